@@ -0,0 +1,137 @@
+//--------------------------------------------------
+// Robot Simulator
+// allocationBenchmark.cpp
+// Date: 17/10/2026
+// By Breno Cunha Queiroz
+//--------------------------------------------------
+// Heap allocations per frame of a Detector (detection, decoding and poses)
+// once it has seen every frame a first time, with both quadrangle engines. Every operator new is counted,
+// worker threads included. The TagTracker (-t) is measured too, on a static
+// scene shaken by a few pixels with a full scan every 8 frames. One JSON
+// object per line and configuration is printed to stdout, the exit code is 1
+// if a frame allocated anything.
+// Usage: allocationBenchmark [frames] [threads]
+#include <iostream>
+#include <vector>
+#include <atomic>
+#include <new>
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+#include "detector.hpp"
+#include "decoder.hpp"
+#include "tracker.hpp"
+#include "synthetic.hpp"
+
+static std::atomic<long> allocations(0);
+
+void* countedAllocation(size_t size, size_t alignment)
+{
+	allocations++;
+	size = std::max<size_t>(size, 1);
+	void* pointer = alignment>alignof(std::max_align_t) ?
+		aligned_alloc(alignment, (size+alignment-1)/alignment*alignment) : malloc(size);
+	if(pointer==nullptr)
+		throw std::bad_alloc();
+	return pointer;
+}
+
+void* operator new(size_t size) { return countedAllocation(size, 0); }
+void* operator new[](size_t size) { return countedAllocation(size, 0); }
+void* operator new(size_t size, std::align_val_t alignment) { return countedAllocation(size, size_t(alignment)); }
+void* operator new[](size_t size, std::align_val_t alignment) { return countedAllocation(size, size_t(alignment)); }
+void operator delete(void* pointer) noexcept { free(pointer); }
+void operator delete[](void* pointer) noexcept { free(pointer); }
+void operator delete(void* pointer, size_t) noexcept { free(pointer); }
+void operator delete[](void* pointer, size_t) noexcept { free(pointer); }
+void operator delete(void* pointer, std::align_val_t) noexcept { free(pointer); }
+void operator delete[](void* pointer, std::align_val_t) noexcept { free(pointer); }
+void operator delete(void* pointer, size_t, std::align_val_t) noexcept { free(pointer); }
+void operator delete[](void* pointer, size_t, std::align_val_t) noexcept { free(pointer); }
+
+// The scene moved by (dx,dy) pixels, the uncovered border is black
+Image shiftImage(const Image& image, int dx, int dy)
+{
+	Image result = createImage(image.width, image.height, image.channels);
+	ConstImageView src = image.view();
+	ImageView dst = result.view();
+	int rowSize = (image.width-dx)*image.channels;
+	for(int y=dy;y<(int)image.height;y++)
+		std::copy(src.row(y-dy), src.row(y-dy)+rowSize, dst.row(y)+dx*image.channels);
+	return result;
+}
+
+int main(int argc, char** argv)
+{
+	int frames = argc>1 ? std::max(1, std::atoi(argv[1])) : 20;
+	int threads = argc>2 ? std::max(1, std::atoi(argv[2])) : hardwareThreads();
+
+	// A few different frames, so the buffers have to fit the largest of them
+	std::vector<SyntheticFrame> inputs;
+	for(int seed=1;seed<=4;seed++)
+		inputs.push_back(generateSyntheticFrame(SyntheticOptions(), seed));
+	const Image& first = inputs.front().image;
+	// Fewer and smaller tags for the tracker, so the regions do not cover the frame
+	SyntheticOptions sparse;
+	sparse.tags = 3;
+	sparse.maxSize = 100;
+	SyntheticFrame scene = generateSyntheticFrame(sparse, 1);
+	std::vector<Image> shaken;
+	for(int shift=0;shift<4;shift++)
+		shaken.push_back(shiftImage(scene.image, shift, shift/2));
+	CameraIntrinsics camera;
+	camera.fx = camera.fy = first.width;
+	camera.cx = first.width/2.0;
+	camera.cy = first.height/2.0;
+
+	const int fullScanEvery = 8;
+	bool clean = true;
+	for(bool tracking : {false, true})
+		for(QuadEngine engine : {QuadEngine::LINES, QuadEngine::CONTOURS})
+			for(int levels=0;levels<=2;levels++)
+				for(int numThreads : {1, threads})
+				{
+					Detector detector(levels, numThreads, engine);
+					TagTracker tracker(fullScanEvery, levels, engine);
+					long tags = 0;
+					long fullScans = 0;
+					auto process = [&](int i)
+					{
+						ConstImageView image = tracking ? shaken[i%shaken.size()].view() : inputs[i%inputs.size()].image.view();
+						Detection& detection = tracking ? tracker.update(image, numThreads, true) : detector.detect(image);
+						decodeTags(image, detection, tracking ? tracker.arena() : detector.arena());
+						estimatePoses(detection, camera, 1);
+						tags += detection.quadrangles.size();
+						fullScans += tracking && tracker.wasFullScan();
+					};
+
+					// Warm up: every frame twice, and two full scan periods when tracking
+					int warmUp = tracking ? 2*fullScanEvery : 2*inputs.size();
+					for(int i=0;i<warmUp;i++)
+						process(i);
+
+					long before = allocations;
+					long worst = 0;
+					tags = 0;
+					fullScans = 0;
+					for(int i=0;i<frames;i++)
+					{
+						long start = allocations;
+						process(i);
+						worst = std::max(worst, allocations-start);
+					}
+					long total = allocations-before;
+					clean = clean && total==0;
+
+					printf("{\"mode\":\"%s\",\"engine\":\"%s\",\"levels\":%d,\"threads\":%d,\"frames\":%d,\"fullScans\":%ld,\"tags\":%ld,"
+						"\"allocations\":%ld,\"maxPerFrame\":%ld}\n", tracking ? "tracker" : "detector", engine==QuadEngine::LINES ? "lines" : "contours",
+						levels, numThreads, frames, tracking ? fullScans : frames, tags, total, worst);
+					fflush(stdout);
+					if(numThreads==threads)
+						break;
+				}
+
+	if(!clean)
+		std::cerr << "Frames allocated after the warm up" << std::endl;
+	return clean ? 0 : 1;
+}
@@ -0,0 +1,71 @@
+//--------------------------------------------------
+// Robot Simulator
+// convolutionCheck.cpp
+// Date: 17/10/2026
+// By Breno Cunha Queiroz
+//--------------------------------------------------
+// The SIMD path of separableConvolution() (SSE2, or AVX2 with
+// ARTAG_NATIVE_ARCH) against separableConvolutionScalar(), on random images
+// and kernels. The radii cover the specialized kernels (1 to 3) and the
+// generic ones, the channels 1 and 3 and the generic counts, and the widths
+// are rarely multiples of the vector width. One JSON object is printed to
+// stdout, the exit code is 1 if a pixel differs.
+// Usage: convolutionCheck [cases] [seed]
+#include <iostream>
+#include <vector>
+#include <random>
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+#include "blur.hpp"
+
+int main(int argc, char** argv)
+{
+	int cases = argc>1 ? std::max(1, std::atoi(argv[1])) : 200;
+	uint32_t seed = argc>2 ? std::atoi(argv[2]) : 1;
+
+	std::mt19937 rng(seed);
+	const int channelCounts[4] = {1, 3, 2, 4};
+	long errors = 0, pixels = 0;
+	FrameArena arena;
+	for(int i=0;i<cases;i++)
+	{
+		int radius = 1+rng()%6;
+		int channels = channelCounts[rng()%4];
+		int width = 2*radius+1+rng()%70;
+		int height = 2*radius+1+rng()%40;
+		int numThreads = 1+rng()%4;
+
+		// Random non negative weights, some of them zero
+		std::vector<float> column(2*radius+1), row(2*radius+1);
+		for(auto* weights : {&column, &row})
+			for(auto& w : *weights)
+				w = rng()%4==0 ? 0 : float(rng()%1000);
+		column[radius] += 1;
+		row[radius] += 1;
+		SeparableKernel kernel;
+		if(!makeSeparableKernel(column, row, kernel))
+		{
+			std::cerr << "Kernel " << i << " could not be quantized" << std::endl;
+			return 1;
+		}
+
+		// Saturated images too, the largest column sums
+		Image image = createImage(width, height, channels);
+		for(auto& pixel : image.buffer)
+			pixel = i%4==0 ? 255 : rng()%256;
+
+		arena.reset();
+		Image simd = createImage(width-2*radius, height-2*radius, channels);
+		separableConvolution(image.view(), simd.view(), kernel, arena, true, numThreads);
+		Image reference = separableConvolutionScalar(image, kernel);
+		for(size_t k=0;k<simd.buffer.size();k++)
+			errors += simd.buffer[k]!=reference.buffer[k];
+		pixels += simd.buffer.size();
+	}
+
+	printf("{\"cases\":%d,\"seed\":%u,\"values\":%ld,\"errors\":%ld}\n", cases, seed, pixels, errors);
+	if(errors>0)
+		std::cerr << "The SIMD convolution differs from the scalar reference" << std::endl;
+	return errors==0 ? 0 : 1;
+}
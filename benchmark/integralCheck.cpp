@@ -0,0 +1,75 @@
+//--------------------------------------------------
+// Robot Simulator
+// integralCheck.cpp
+// Date: 17/10/2026
+// By Breno Cunha Queiroz
+//--------------------------------------------------
+// computeIntegralImage() against integralImageScalar(), and boxFilter() and
+// adaptiveThreshold() against the window sums of the scalar table, on random
+// images of random sizes, radii, offsets and thread counts. Tall images are
+// included so the table is split in several bands. One JSON object is printed
+// to stdout, the exit code is 1 if anything differs.
+// Usage: integralCheck [cases] [seed]
+#include <iostream>
+#include <vector>
+#include <random>
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+#include "imgProc.hpp"
+#include "integral.hpp"
+
+int main(int argc, char** argv)
+{
+	int cases = argc>1 ? std::max(1, std::atoi(argv[1])) : 100;
+	uint32_t seed = argc>2 ? std::atoi(argv[2]) : 1;
+
+	std::mt19937 rng(seed);
+	long integralErrors = 0, boxErrors = 0, thresholdErrors = 0;
+	FrameArena arena;
+	for(int i=0;i<cases;i++)
+	{
+		int width = 1+rng()%200;
+		int height = 1+rng()%(i%4==0 ? 1000 : 150);
+		int radius = rng()%24;
+		int offset = int(rng()%21)-10;
+		int numThreads = 1+rng()%6;
+
+		// Saturated images too, the largest sums
+		Image image = createImage(width, height, 1);
+		for(auto& pixel : image.buffer)
+			pixel = i%3==0 ? 255 : rng()%256;
+
+		arena.reset();
+		IntegralImage integral;
+		computeIntegralImage(image.view(), integral, arena, numThreads);
+		std::vector<uint32_t> reference = integralImageScalar(image.view());
+		for(int y=0;y<=height;y++)
+			for(int x=0;x<=width;x++)
+				integralErrors += integral.row(y)[x]!=reference[y*(width+1) + x];
+
+		Image box = createImage(width, height, 1);
+		Image binary = createImage(width, height, 1);
+		boxFilter(image.view(), box.view(), radius, arena, numThreads);
+		adaptiveThreshold(image.view(), binary.view(), radius, offset, arena, numThreads);
+		for(int y=0;y<height;y++)
+			for(int x=0;x<width;x++)
+			{
+				int x0 = std::max(0, x-radius), x1 = std::min(width, x+radius+1);
+				int y0 = std::max(0, y-radius), y1 = std::min(height, y+radius+1);
+				int64_t sum = int64_t(reference[y1*(width+1) + x1])-reference[y1*(width+1) + x0]
+					-reference[y0*(width+1) + x1]+reference[y0*(width+1) + x0];
+				int64_t count = int64_t(x1-x0)*(y1-y0);
+				int pixel = image.view().row(y)[x];
+				boxErrors += box.view().row(y)[x]!=(sum+count/2)/count;
+				thresholdErrors += (binary.view().row(y)[x]==255)!=((pixel+offset)*count>sum);
+			}
+	}
+
+	bool clean = integralErrors==0 && boxErrors==0 && thresholdErrors==0;
+	printf("{\"cases\":%d,\"seed\":%u,\"integralErrors\":%ld,\"boxErrors\":%ld,\"thresholdErrors\":%ld}\n",
+		cases, seed, integralErrors, boxErrors, thresholdErrors);
+	if(!clean)
+		std::cerr << "The integral image or its filters differ from the scalar reference" << std::endl;
+	return clean ? 0 : 1;
+}
@@ -0,0 +1,148 @@
+//--------------------------------------------------
+// Robot Simulator
+// labelingCheck.cpp
+// Date: 17/10/2026
+// By Breno Cunha Queiroz
+//--------------------------------------------------
+// labelComponents() against the recursive flood fill it replaced (seeded on
+// the first unvisited edgel in raster order, 4-connected, every edgel within
+// tolerance of the seed). Both keep every edgel within tolerance of its
+// seed, but the union-find claims the edgels in raster order, so an edgel
+// within tolerance of two seeds can end in another component. A crafted case
+// where merging on the seeds alone would put edgels 2*tolerance apart must
+// give the flood fill components exactly. On the edgels of synthetic frames,
+// one JSON object per frame tells how many components are identical.
+// The exit code is 1 if the crafted case differs.
+// Usage: labelingCheck [frames]
+#include <iostream>
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+#include <tuple>
+#include "detector.hpp"
+#include "labeling.hpp"
+#include "synthetic.hpp"
+
+// Components of the old getRegion() flood fill, with an explicit stack
+std::vector<ComponentMoments> floodFillComponents(ConstImageView edgels, int tolerance)
+{
+	int width = edgels.width;
+	int height = edgels.height;
+	std::vector<char> visited(width*height, 0);
+	std::vector<ComponentMoments> components;
+	std::vector<std::pair<int, int>> stack;
+	for(int y=0;y<height;y++)
+		for(int x=0;x<width;x++)
+		{
+			unsigned char seed = edgels.row(y)[x];
+			if(seed==0 || visited[y*width+x])
+				continue;
+
+			ComponentMoments moments;
+			stack.push_back({x, y});
+			while(!stack.empty())
+			{
+				int px = stack.back().first;
+				int py = stack.back().second;
+				stack.pop_back();
+				if(px<0 || py<0 || px>=width || py>=height || visited[py*width+px])
+					continue;
+				unsigned char value = edgels.row(py)[px];
+				if(value==0 || orientationDistance(value, seed)>tolerance)
+					continue;
+				visited[py*width+px] = 1;
+				moments.add(px, py);
+				stack.push_back({px+1, py});
+				stack.push_back({px-1, py});
+				stack.push_back({px, py+1});
+				stack.push_back({px, py-1});
+			}
+			components.push_back(moments);
+		}
+	return components;
+}
+
+// Same edgels, the moments identify a component
+std::tuple<int, int64_t, int64_t, int64_t, int64_t, int64_t> componentKey(const ComponentMoments& moments)
+{
+	return std::make_tuple(moments.count, moments.sumX, moments.sumY, moments.sumXsquare, moments.sumYsquare, moments.sumXY);
+}
+
+struct Comparison
+{
+	int floodFill = 0;// Components
+	int unionFind = 0;
+	int identical = 0;
+	long edgels = 0;
+	long identicalEdgels = 0;// In the identical components
+	int floodFillLines = 0;// Components of at least 20 edgels, as kept by computeLines()
+	int unionFindLines = 0;
+};
+
+Comparison compareLabelings(ConstImageView edgels, int tolerance)
+{
+	std::vector<ComponentMoments> reference = floodFillComponents(edgels, tolerance);
+	std::vector<ComponentMoments> labeled = labelComponents(edgels, tolerance);
+	std::vector<std::tuple<int, int64_t, int64_t, int64_t, int64_t, int64_t>> keys;
+	for(const auto& moments : reference)
+		keys.push_back(componentKey(moments));
+	std::sort(keys.begin(), keys.end());
+
+	Comparison comparison;
+	comparison.floodFill = reference.size();
+	comparison.unionFind = labeled.size();
+	for(const auto& moments : reference)
+	{
+		comparison.edgels += moments.count;
+		comparison.floodFillLines += moments.count>=20;
+	}
+	for(const auto& moments : labeled)
+	{
+		comparison.unionFindLines += moments.count>=20;
+		if(std::binary_search(keys.begin(), keys.end(), componentKey(moments)))
+		{
+			comparison.identical++;
+			comparison.identicalEdgels += moments.count;
+		}
+	}
+	return comparison;
+}
+
+int main(int argc, char** argv)
+{
+	int frames = argc>1 ? std::max(1, std::atoi(argv[1])) : 4;
+	const int tolerance = 25;
+
+	// Seeds 100 and 120 agree, but 80 and 140 are 60 apart: the flood fill of
+	// 100 stops before 140, so the two columns must not be merged on the last row
+	const unsigned char crafted[3][3] =
+	{
+		{100, 0, 120},
+		{80, 0, 140},
+		{110, 110, 110}
+	};
+	Image image = createImage(3, 3, 1);
+	for(int y=0;y<3;y++)
+		std::copy(crafted[y], crafted[y]+3, image.view().row(y));
+	Comparison craftedComparison = compareLabelings(image.view(), tolerance);
+	bool clean = craftedComparison.identical==craftedComparison.floodFill && craftedComparison.unionFind==craftedComparison.floodFill;
+	printf("{\"input\":\"crafted\",\"floodFill\":%d,\"unionFind\":%d,\"identical\":%d}\n",
+		craftedComparison.floodFill, craftedComparison.unionFind, craftedComparison.identical);
+
+	for(int seed=1;seed<=frames;seed++)
+	{
+		SyntheticFrame frame = generateSyntheticFrame(SyntheticOptions(), seed);
+		Detection detection = detectARtags(frame.image.view());
+		Comparison comparison = compareLabelings(detection.edgels.view(), tolerance);
+		printf("{\"input\":\"synthetic\",\"seed\":%d,\"edgels\":%ld,\"floodFill\":%d,\"unionFind\":%d,\"identical\":%d,"
+			"\"identicalEdgels\":%.4f,\"floodFillLines\":%d,\"unionFindLines\":%d}\n",
+			seed, comparison.edgels, comparison.floodFill, comparison.unionFind, comparison.identical,
+			comparison.edgels>0 ? double(comparison.identicalEdgels)/comparison.edgels : 1.0,
+			comparison.floodFillLines, comparison.unionFindLines);
+	}
+
+	if(!clean)
+		std::cerr << "The crafted case differs from the flood fill" << std::endl;
+	return clean ? 0 : 1;
+}
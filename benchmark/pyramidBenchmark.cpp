@@ -0,0 +1,64 @@
+//--------------------------------------------------
+// Robot Simulator
+// pyramidBenchmark.cpp
+// Date: 17/10/2026
+// By Breno Cunha Queiroz
+//--------------------------------------------------
+// Speed against recall of the coarse to fine detection for every pyramid depth.
+// Usage: pyramidBenchmark [frames] [width] [height] [maxLevels]
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <chrono>
+#include <cstdlib>
+#include "detector.hpp"
+#include "synthetic.hpp"
+
+int main(int argc, char** argv)
+{
+	int frames = argc>1 ? std::atoi(argv[1]) : 20;
+	SyntheticOptions options;
+	if(argc>3)
+	{
+		options.width = std::atoi(argv[2]);
+		options.height = std::atoi(argv[3]);
+	}
+	int maxLevels = argc>4 ? std::atoi(argv[4]) : 3;
+	const float tolerance = 3;// Pixels
+
+	std::vector<SyntheticFrame> dataset;
+	int totalTags = 0;
+	for(int i=0;i<frames;i++)
+	{
+		dataset.push_back(generateSyntheticFrame(options, i+1));
+		totalTags += dataset.back().tags.size();
+	}
+
+	std::cout << "Frames: " << frames << " (" << options.width << "x" << options.height << ", "
+		<< totalTags << " tags), corner tolerance " << tolerance << "px" << std::endl;
+	std::cout << "levels   ms/frame   recall   corner error (px)   quads/frame" << std::endl;
+	for(int levels=0;levels<=maxLevels;levels++)
+	{
+		typedef std::chrono::steady_clock Clock;
+		double milliseconds = 0;
+		int found = 0;
+		int quads = 0;
+		float errorSum = 0;
+		for(const auto& frame : dataset)
+		{
+			Clock::time_point start = Clock::now();
+			Detection detection = detectARtagsPyramid(frame.image.view(), levels);
+			milliseconds += std::chrono::duration<double, std::milli>(Clock::now()-start).count();
+
+			found += countFoundTags(frame.tags, detection.quadrangles, tolerance, &errorSum);
+			quads += detection.quadrangles.size();
+		}
+		std::cout << std::fixed << std::setprecision(2)
+			<< std::setw(6) << levels
+			<< std::setw(11) << milliseconds/frames
+			<< std::setw(9) << (totalTags>0 ? float(found)/totalTags : 0)
+			<< std::setw(20) << (found>0 ? errorSum/found : 0)
+			<< std::setw(14) << float(quads)/frames << std::endl;
+	}
+	return 0;
+}
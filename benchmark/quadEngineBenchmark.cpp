@@ -0,0 +1,78 @@
+//--------------------------------------------------
+// Robot Simulator
+// quadEngineBenchmark.cpp
+// Date: 17/10/2026
+// By Breno Cunha Queiroz
+//--------------------------------------------------
+// Line graph against contour quadrangle engine on synthetic frames with more
+// and more background clutter: mean and worst frame time, recall and corner error.
+// Usage: quadEngineBenchmark [frames] [width] [height] [threads]
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <chrono>
+#include <cstdlib>
+#include <algorithm>
+#include "detector.hpp"
+#include "synthetic.hpp"
+
+int main(int argc, char** argv)
+{
+	int frames = argc>1 ? std::max(1, std::atoi(argv[1])) : 10;
+	SyntheticOptions options;
+	if(argc>3)
+	{
+		options.width = std::atoi(argv[2]);
+		options.height = std::atoi(argv[3]);
+	}
+	int threads = argc>4 ? std::max(1, std::atoi(argv[4])) : 1;
+	const float tolerance = 3;// Pixels
+
+	std::cout << "Frames: " << frames << " (" << options.width << "x" << options.height << ", "
+		<< options.tags << " tags), " << threads << " threads, corner tolerance " << tolerance << "px" << std::endl;
+	std::cout << "clutter  engine     ms/frame  worst ms   recall   corner error (px)   quads/frame" << std::endl;
+	for(float clutter : {0.0f, 0.3f, 0.6f, 0.9f})
+	{
+		options.texture = clutter;
+		std::vector<SyntheticFrame> dataset;
+		int totalTags = 0;
+		for(int i=0;i<frames;i++)
+		{
+			dataset.push_back(generateSyntheticFrame(options, i+1));
+			totalTags += dataset.back().tags.size();
+		}
+
+		for(QuadEngine engine : {QuadEngine::LINES, QuadEngine::CONTOURS})
+		{
+			typedef std::chrono::steady_clock Clock;
+			Detector detector(0, threads, engine);
+			detector.detect(dataset.front().image.view());// Buffers allocated out of the timings
+
+			double milliseconds = 0;
+			double worst = 0;
+			int found = 0;
+			int quads = 0;
+			float errorSum = 0;
+			for(const auto& frame : dataset)
+			{
+				Clock::time_point start = Clock::now();
+				Detection& detection = detector.detect(frame.image.view());
+				double frameMilliseconds = std::chrono::duration<double, std::milli>(Clock::now()-start).count();
+				milliseconds += frameMilliseconds;
+				worst = std::max(worst, frameMilliseconds);
+
+				found += countFoundTags(frame.tags, detection.quadrangles, tolerance, &errorSum);
+				quads += detection.quadrangles.size();
+			}
+			std::cout << std::fixed << std::setprecision(2)
+				<< std::setw(7) << clutter
+				<< std::setw(10) << (engine==QuadEngine::LINES ? "lines" : "contours")
+				<< std::setw(13) << milliseconds/frames
+				<< std::setw(10) << worst
+				<< std::setw(9) << (totalTags>0 ? float(found)/totalTags : 0)
+				<< std::setw(20) << (found>0 ? errorSum/found : 0)
+				<< std::setw(14) << float(quads)/frames << std::endl;
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,175 @@
+//--------------------------------------------------
+// Robot Simulator
+// stageBenchmark.cpp
+// Date: 17/10/2026
+// By Breno Cunha Queiroz
+//--------------------------------------------------
+// Time of every pipeline stage on synthetic frames from VGA to 4K. One JSON
+// object per line and stage is printed to stdout, so runs can be diffed.
+// Usage: stageBenchmark [repetitions] [tags] [clutter] [threads] [gradient]
+// clutter is the fraction of the background covered by fine texture, gradient
+// 1 uses the populateImage() background instead of gray shading.
+#include <iostream>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+#include "detector.hpp"
+#include "synthetic.hpp"
+#include "png.hpp"
+
+// Bottom-up 24 bit BMP, like the gallery files
+bool writeBmpFile(const std::string& path, const Image& image)
+{
+	int rowSize = (image.width*3+3)&~3;
+	uint32_t dataSize = rowSize*image.height;
+	unsigned char header[54] = {'B', 'M'};
+	auto put32 = [&](int offset, uint32_t value) { for(int k=0;k<4;k++) header[offset+k] = value>>(8*k); };
+	put32(2, 54+dataSize);
+	put32(10, 54);
+	put32(14, 40);
+	put32(18, image.width);
+	put32(22, image.height);
+	header[26] = 1;
+	header[28] = 24;
+	put32(34, dataSize);
+
+	FILE* file = fopen(path.c_str(), "wb");
+	if(file==nullptr)
+		return false;
+	fwrite(header, 1, sizeof(header), file);
+	std::vector<unsigned char> row(rowSize, 0);
+	for(int y=image.height-1;y>=0;y--)
+	{
+		const unsigned char* src = &image.buffer[y*image.width*image.channels];
+		for(int x=0;x<(int)image.width;x++)
+			for(int c=0;c<3;c++)
+				row[x*3+c] = src[x*image.channels + std::min(c, image.channels-1)];
+		fwrite(row.data(), 1, rowSize, file);
+	}
+	fclose(file);
+	return true;
+}
+
+struct Timing
+{
+	double median = 0;
+	double min = 0;
+};
+
+// Milliseconds of run, one untimed warm up call first
+template<typename Function>
+Timing timeStage(int repetitions, Function run)
+{
+	typedef std::chrono::steady_clock Clock;
+	run();
+	std::vector<double> samples;
+	for(int i=0;i<repetitions;i++)
+	{
+		Clock::time_point start = Clock::now();
+		run();
+		samples.push_back(std::chrono::duration<double, std::milli>(Clock::now()-start).count());
+	}
+	std::sort(samples.begin(), samples.end());
+	Timing timing;
+	timing.median = samples[samples.size()/2];
+	timing.min = samples.front();
+	return timing;
+}
+
+int main(int argc, char** argv)
+{
+	int repetitions = argc>1 ? std::max(1, std::atoi(argv[1])) : 10;
+	int tags = argc>2 ? std::atoi(argv[2]) : 8;
+	float clutter = argc>3 ? std::atof(argv[3]) : 0.3f;
+	int threads = argc>4 ? std::max(1, std::atoi(argv[4])) : 1;
+	bool gradient = argc>5 && std::atoi(argv[5])!=0;
+	const std::string bmpPath = "stageBenchmark.bmp";
+	const std::string pngPath = "stageBenchmark.png";
+
+	const int resolutions[][2] = {{640, 480}, {1280, 720}, {1920, 1080}, {3840, 2160}};
+	for(const auto& resolution : resolutions)
+	{
+		SyntheticOptions options;
+		options.width = resolution[0];
+		options.height = resolution[1];
+		options.tags = tags;
+		options.texture = clutter;
+		options.gradient = gradient;
+		// Same apparent tag sizes at every resolution
+		options.minSize = options.height/24.0f;
+		options.maxSize = options.height/6.0f;
+		SyntheticFrame frame = generateSyntheticFrame(options, 1);
+		std::cerr << "Benchmarking " << options.width << "x" << options.height << std::endl;
+
+		// Inputs of every stage, from the output of the previous one
+		std::vector<float> kernel(25);
+		const float gaussian[5] = {1, 4, 7, 4, 1};
+		for(int i=0;i<25;i++)
+			kernel[i] = gaussian[i/5]*gaussian[i%5]/(17*17);
+		// Rank 2 (a cross), so it can not go through the separable engine
+		std::vector<float> cross(25, 0);
+		for(int i=0;i<5;i++)
+			cross[2*5+i] = cross[i*5+2] = 1/9.f;
+		Image gray = grayscaleMax(frame.image, threads);
+		Image smooth = convolution(gray, kernel, threads);
+		Image edgels = computeEdgels(smooth, 20, threads);
+		std::vector<Line> lines = computeLines(edgels);
+		LineGraph graph = buildLineGraph(lines, 5, 0.5);
+		writeBmpFile(bmpPath, frame.image);
+
+		std::vector<std::pair<std::string, Timing>> stages;
+		stages.push_back({"grayscaleMax", timeStage(repetitions, [&]() { grayscaleMax(frame.image.view(), gray.view(), threads); })});
+		stages.push_back({"convolution", timeStage(repetitions, [&]() { convolution(gray.view(), smooth.view(), kernel, threads); })});
+		stages.push_back({"convolutionGeneric", timeStage(repetitions, [&]() { convolution(gray.view(), smooth.view(), cross, threads); })});
+		stages.push_back({"computeEdgels", timeStage(repetitions, [&]() { computeEdgels(smooth.view(), edgels.view(), 20, threads); })});
+		stages.push_back({"computeEdgelsFused", timeStage(repetitions, [&]()
+			{
+				computeEdgelsFused(frame.image.view(), edgels.view(), detectionKernel(), 20, threads);
+			})});
+		// Radius 15 (31x31 windows), the time should not depend on it
+		Image binary = createImage(gray.width, gray.height, 1);
+		FrameArena arena;
+		stages.push_back({"integralImage", timeStage(repetitions, [&]()
+			{
+				arena.reset();
+				IntegralImage integral;
+				computeIntegralImage(gray.view(), integral, arena, threads);
+			})});
+		stages.push_back({"boxFilter", timeStage(repetitions, [&]()
+			{
+				arena.reset();
+				boxFilter(gray.view(), binary.view(), 15, arena, threads);
+			})});
+		stages.push_back({"adaptiveThreshold", timeStage(repetitions, [&]()
+			{
+				arena.reset();
+				adaptiveThreshold(gray.view(), binary.view(), 15, 15, arena, threads);
+			})});
+		stages.push_back({"computeLines", timeStage(repetitions, [&]() { computeLines(edgels.view()); })});
+		stages.push_back({"computeQuadrangles", timeStage(repetitions, [&]() { computeQuadrangles(lines); })});
+		stages.push_back({"findQuadrangles", timeStage(repetitions, [&]() { findQuadrangles(lines, graph); })});
+		// Contour engine on the adaptive threshold, against computeQuadrangles()
+		stages.push_back({"findContourQuadrangles", timeStage(repetitions, [&]() { findContourQuadrangles(binary, 0); })});
+		stages.push_back({"readBmp", timeStage(repetitions, [&]() { readBmpFile(bmpPath); })});
+		stages.push_back({"writePng", timeStage(repetitions, [&]() { writePngFile(pngPath, frame.image.view()); })});
+		stages.push_back({"detectARtags", timeStage(repetitions, [&]() { detectARtags(frame.image.view(), threads); })});
+		Detector detector(0, threads);
+		stages.push_back({"detector", timeStage(repetitions, [&]() { detector.detect(frame.image.view()); })});
+		Detector contourDetector(0, threads, QuadEngine::CONTOURS);
+		stages.push_back({"detectorContours", timeStage(repetitions, [&]() { contourDetector.detect(frame.image.view()); })});
+
+		for(const auto& stage : stages)
+			printf("{\"resolution\":\"%dx%d\",\"width\":%d,\"height\":%d,\"tags\":%d,\"clutter\":%.2f,\"gradient\":%s,"
+				"\"threads\":%d,\"lines\":%zu,\"stage\":\"%s\",\"repetitions\":%d,\"medianMs\":%.4f,\"minMs\":%.4f}\n",
+				options.width, options.height, options.width, options.height, (int)frame.tags.size(), clutter,
+				gradient ? "true" : "false", threads, lines.size(), stage.first.c_str(), repetitions,
+				stage.second.median, stage.second.min);
+		fflush(stdout);
+	}
+	std::remove(bmpPath.c_str());
+	std::remove(pngPath.c_str());
+	return 0;
+}
@@ -1 +0,0 @@
-#include "svpng.h"
@@ -0,0 +1,197 @@
+//--------------------------------------------------
+// Robot Simulator
+// arena.hpp
+// Date: 17/10/2026
+// By Breno Cunha Queiroz
+//--------------------------------------------------
+#ifndef ARENA_H
+#define ARENA_H
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <new>
+#include <cstdint>
+#include <algorithm>
+#include <type_traits>
+#include "helpers.hpp"
+
+//--------------------//
+//------- Arena ------//
+//--------------------//
+// Bump allocator for the scratch buffers of one frame, reset once per frame.
+// Allocation is a single atomic add, so parallel bands can allocate too.
+// A frame that does not fit gets heap blocks, and the next reset() grows the
+// arena to the size that frame needed: after the first frames nothing is allocated.
+class FrameArena
+{
+public:
+	FrameArena() = default;
+	FrameArena(const FrameArena&) = delete;
+	FrameArena& operator=(const FrameArena&) = delete;
+	~FrameArena() { releaseOverflow(); }
+
+	// n uninitialized elements, cache line aligned, valid until reset()
+	template<typename T>
+	T* allocate(size_t n)
+	{
+		static_assert(std::is_trivially_copyable<T>::value && std::is_trivially_destructible<T>::value,
+			"Arena memory is never destroyed");
+		size_t bytes = (std::max<size_t>(n*sizeof(T), 1)+ALIGNMENT-1)&~(ALIGNMENT-1);
+		size_t offset = used.fetch_add(bytes);
+		if(offset+bytes<=capacity)
+			return reinterpret_cast<T*>(base+offset);
+
+		std::lock_guard<std::mutex> lock(overflowMutex);
+		void* block = ::operator new(bytes, std::align_val_t(ALIGNMENT));
+		overflow.push_back(block);
+		return static_cast<T*>(block);
+	}
+
+	void reset()
+	{
+		size_t needed = used.load();
+		releaseOverflow();
+		if(needed>capacity)
+		{
+			capacity = needed + needed/4;
+			storage.reset(new unsigned char[capacity+ALIGNMENT]);
+			base = storage.get() + (ALIGNMENT - uintptr_t(storage.get())%ALIGNMENT)%ALIGNMENT;
+		}
+		used = 0;
+	}
+
+	size_t size() const { return capacity; }
+
+private:
+	static constexpr size_t ALIGNMENT = 64;
+
+	void releaseOverflow()
+	{
+		std::lock_guard<std::mutex> lock(overflowMutex);
+		for(void* block : overflow)
+			::operator delete(block, std::align_val_t(ALIGNMENT));
+		overflow.clear();
+	}
+
+	std::unique_ptr<unsigned char[]> storage;
+	unsigned char* base = nullptr;
+	size_t capacity = 0;
+	std::atomic<size_t> used{0};
+	std::mutex overflowMutex;
+	std::vector<void*> overflow;
+};
+
+// Growable array in arena memory for trivially copyable elements. Growing
+// copies to a new arena block, the old one is only reclaimed by reset().
+template<typename T>
+class ArenaVector
+{
+public:
+	explicit ArenaVector(FrameArena& arena, size_t reserved=0): arena(&arena)
+	{
+		if(reserved>0)
+			reserve(reserved);
+	}
+
+	void reserve(size_t n)
+	{
+		if(n<=capacity)
+			return;
+		T* grown = arena->allocate<T>(n);
+		std::copy(items, items+count, grown);
+		items = grown;
+		capacity = n;
+	}
+
+	void push_back(const T& value)
+	{
+		if(count==capacity)
+			reserve(std::max<size_t>(16, capacity*2));
+		new(items+count) T(value);
+		count++;
+	}
+
+	// New elements are value initialized
+	void resize(size_t n, const T& value=T())
+	{
+		reserve(n);
+		for(size_t i=count;i<n;i++)
+			new(items+i) T(value);
+		count = n;
+	}
+
+	void clear() { count = 0; }
+	size_t size() const { return count; }
+	bool empty() const { return count==0; }
+	T* data() { return items; }
+	const T* data() const { return items; }
+	T& operator[](size_t i) { return items[i]; }
+	const T& operator[](size_t i) const { return items[i]; }
+	T& back() { return items[count-1]; }
+	T* begin() { return items; }
+	T* end() { return items+count; }
+	const T* begin() const { return items; }
+	const T* end() const { return items+count; }
+
+private:
+	FrameArena* arena;
+	T* items = nullptr;
+	size_t count = 0;
+	size_t capacity = 0;
+};
+
+//--------------------//
+//---- Image pool ----//
+//--------------------//
+// Image buffers recycled across frames: acquire() returns a released image of
+// the same size if there is one (its pixels are not cleared), else the smallest
+// released buffer large enough resized, so sizes changing by a few pixels (e.g.
+// the tracked regions) do not allocate, or a new one.
+class ImagePool
+{
+public:
+	Image acquire(uint32_t width, uint32_t height, uint8_t channels)
+	{
+		size_t size = size_t(width)*height*channels;
+		size_t best = images.size();
+		for(size_t i=0;i<images.size();i++)
+		{
+			if(images[i].width==width && images[i].height==height && images[i].channels==channels)
+			{
+				best = i;
+				break;
+			}
+			if(images[i].buffer.capacity()>=size && (best==images.size() || images[i].buffer.capacity()<images[best].buffer.capacity()))
+				best = i;
+		}
+		if(best==images.size())
+			return createImage(width, height, channels);
+
+		Image image = std::move(images[best]);
+		images.erase(images.begin()+best);
+		image.buffer.resize(size);
+		image.width = width;
+		image.height = height;
+		image.channels = channels;
+		return image;
+	}
+
+	void release(Image&& image)
+	{
+		if(!image.buffer.empty())
+		{
+			// The oldest buffers go first when the sizes keep changing
+			if(images.size()>=MAX_IMAGES)
+				images.erase(images.begin());
+			images.push_back(std::move(image));
+		}
+		image = Image();
+	}
+
+private:
+	static constexpr size_t MAX_IMAGES = 16;
+	std::vector<Image> images;
+};
+
+#endif// ARENA_H
@@ -0,0 +1,224 @@
+//--------------------------------------------------
+// Robot Simulator
+// batch.hpp
+// Date: 17/10/2026
+// By Breno Cunha Queiroz
+//--------------------------------------------------
+#ifndef BATCH_H
+#define BATCH_H
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <chrono>
+#include <functional>
+#include <algorithm>
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <filesystem>
+#include <array>
+#include <cmath>
+
+struct BatchStats
+{
+	int frames = 0;
+	double seconds = 0;
+	double framesPerSecond = 0;
+	double p50 = 0;// Frame latency (ms)
+	double p99 = 0;// Frame latency (ms)
+};
+
+// Per worker queue: the owner pops from the front, thieves steal from the back
+class WorkStealingQueue
+{
+public:
+	void push(int item)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		items.push_back(item);
+	}
+
+	bool pop(int& item)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if(items.empty())
+			return false;
+		item = items.front();
+		items.pop_front();
+		return true;
+	}
+
+	bool steal(int& item)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if(items.empty())
+			return false;
+		item = items.back();
+		items.pop_back();
+		return true;
+	}
+
+private:
+	std::deque<int> items;
+	std::mutex mutex;
+};
+
+double percentile(std::vector<double> values, double p)
+{
+	if(values.empty())
+		return 0;
+	std::sort(values.begin(), values.end());
+	int index = std::min((int)values.size()-1, int(p*values.size()));
+	return values[index];
+}
+
+// Latencies of an unbounded stream in fixed memory: logarithmic bins 2% wide
+// from 1us to about 10 minutes, percentiles are exact to a bin
+class LatencyHistogram
+{
+public:
+	void add(double milliseconds)
+	{
+		int bin = 0;
+		if(milliseconds>MIN_LATENCY)
+			bin = std::min(BINS-1, int(std::log(milliseconds/MIN_LATENCY)/std::log(BIN_RATIO))+1);
+		bins[bin]++;
+		count++;
+		minimum = std::min(minimum, milliseconds);
+		maximum = std::max(maximum, milliseconds);
+	}
+
+	// Same rank as percentile(), the geometric center of its bin clamped to the extremes
+	double percentile(double p) const
+	{
+		if(count==0)
+			return 0;
+		long rank = std::min(count-1, long(p*count));
+		long seen = 0;
+		int bin = 0;
+		for(;bin<BINS-1;bin++)
+		{
+			seen += bins[bin];
+			if(seen>rank)
+				break;
+		}
+		double center = bin==0 ? MIN_LATENCY : MIN_LATENCY*std::pow(BIN_RATIO, bin-0.5);
+		return std::min(maximum, std::max(minimum, center));
+	}
+
+private:
+	static constexpr int BINS = 1024;
+	static constexpr double MIN_LATENCY = 1e-3;// Milliseconds
+	static constexpr double BIN_RATIO = 1.02;
+
+	std::array<long, BINS> bins = {};
+	long count = 0;
+	double minimum = INFINITY;
+	double maximum = 0;
+};
+
+// Run process(i) for every i in [0,count) on numWorkers threads. Items are dealt
+// round robin so the workers advance through the input together, idle workers
+// steal from the others. commit(i) is called once per item in increasing order
+// (never concurrently) as soon as all the previous items are processed.
+BatchStats runBatch(int count, int numWorkers, const std::function<void(int)>& process, const std::function<void(int)>& commit)
+{
+	typedef std::chrono::steady_clock Clock;
+	numWorkers = std::max(1, std::min(numWorkers, count));
+
+	std::vector<WorkStealingQueue> queues(numWorkers);
+	for(int i=0;i<count;i++)
+		queues[i%numWorkers].push(i);
+
+	std::vector<double> latencies(count);
+	std::vector<char> processed(count, 0);
+	int nextCommit = 0;
+	std::mutex commitMutex;
+
+	auto worker = [&](int id)
+	{
+		int item;
+		while(true)
+		{
+			bool found = queues[id].pop(item);
+			for(int k=1;k<numWorkers && !found;k++)
+				found = queues[(id+k)%numWorkers].steal(item);
+			if(!found)
+				return;// Nothing is ever pushed after the start, so all queues are empty
+
+			Clock::time_point start = Clock::now();
+			process(item);
+			latencies[item] = std::chrono::duration<double, std::milli>(Clock::now()-start).count();
+
+			std::lock_guard<std::mutex> lock(commitMutex);
+			processed[item] = 1;
+			while(nextCommit<count && processed[nextCommit])
+				commit(nextCommit++);
+		}
+	};
+
+	Clock::time_point start = Clock::now();
+	std::vector<std::thread> threads;
+	for(int i=1;i<numWorkers;i++)
+		threads.emplace_back(worker, i);
+	worker(0);
+	for(auto& thread : threads)
+		thread.join();
+
+	BatchStats stats;
+	stats.frames = count;
+	stats.seconds = std::chrono::duration<double>(Clock::now()-start).count();
+	stats.framesPerSecond = stats.seconds>0 ? count/stats.seconds : 0;
+	stats.p50 = percentile(latencies, 0.50);
+	stats.p99 = percentile(latencies, 0.99);
+	return stats;
+}
+
+// Inputs can be images, directories (all their images, sorted by name) or
+// .txt files with one image path per line
+std::vector<std::string> listImages(const std::vector<std::string>& inputs, const std::string& extension=".bmp")
+{
+	namespace fs = std::filesystem;
+	std::vector<std::string> files;
+	for(const auto& input : inputs)
+	{
+		std::error_code error;
+		if(fs::is_directory(input, error))
+		{
+			std::vector<std::string> directoryFiles;
+			for(const auto& entry : fs::directory_iterator(input, error))
+				if(entry.is_regular_file() && entry.path().extension()==extension)
+					directoryFiles.push_back(entry.path().string());
+			std::sort(directoryFiles.begin(), directoryFiles.end());
+			files.insert(files.end(), directoryFiles.begin(), directoryFiles.end());
+		}
+		else if(fs::path(input).extension()==".txt")
+		{
+			std::ifstream list(input);
+			std::string line;
+			while(std::getline(list, line))
+				if(!line.empty())
+					files.push_back(line);
+		}
+		else
+			files.push_back(input);
+	}
+	return files;
+}
+
+std::string fileStem(const std::string& path)
+{
+	return std::filesystem::path(path).stem().string();
+}
+
+void printBatchStats(const BatchStats& stats)
+{
+	std::cerr << "Frames: " << stats.frames
+		<< " time: " << stats.seconds << "s"
+		<< " throughput: " << stats.framesPerSecond << " frames/s"
+		<< " latency p50: " << stats.p50 << "ms"
+		<< " p99: " << stats.p99 << "ms" << std::endl;
+}
+
+#endif// BATCH_H
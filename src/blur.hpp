@@ -0,0 +1,421 @@
+//--------------------------------------------------
+// Robot Simulator
+// blur.hpp
+// Date: 17/10/2026
+// By Breno Cunha Queiroz
+//--------------------------------------------------
+#ifndef BLUR_H
+#define BLUR_H
+#include <vector>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+#include "helpers.hpp"
+#include "threadPool.hpp"
+#include "arena.hpp"
+
+// The 1D weights are stored in fixed point and always sum to 1<<BLUR_WEIGHT_BITS.
+// With 7 bits the vertical pass fits in 16 bits (255*128) and the horizontal
+// pass result fits in a signed 16 bit madd operand.
+#define BLUR_WEIGHT_BITS 7
+
+struct SeparableKernel
+{
+	std::vector<int16_t> column;// Vertical pass weights
+	std::vector<int16_t> row;// Horizontal pass weights
+	int radius = 0;
+};
+
+//--------------------//
+//------ Kernel ------//
+//--------------------//
+// Convert normalized float weights to fixed point weights that sum exactly to 1<<BLUR_WEIGHT_BITS
+std::vector<int16_t> quantizeKernel(const std::vector<float>& weights)
+{
+	float sum = 0;
+	for(auto w : weights)
+	{
+		if(w<0)
+			return {};
+		sum += w;
+	}
+	if(sum<=0)
+		return {};
+
+	const int one = 1<<BLUR_WEIGHT_BITS;
+	std::vector<int16_t> result(weights.size());
+	int total = 0;
+	int largest = 0;
+	for(int i=0;i<(int)weights.size();i++)
+	{
+		result[i] = (int16_t)std::lround(weights[i]/sum*one);
+		total += result[i];
+		if(weights[i]>weights[largest])
+			largest = i;
+	}
+	// Rounding residual goes to the largest weight
+	result[largest] += one-total;
+	return result;
+}
+
+// Split a square 2D kernel into column*row. Returns false if the kernel is not rank one.
+bool factorizeKernel(const std::vector<float>& kernel, std::vector<float>& column, std::vector<float>& row, float tolerance=1e-4f)
+{
+	int size = std::lround(sqrt(kernel.size()));
+	if(size*size!=(int)kernel.size() || size%2==0)
+		return false;
+
+	// Pivot on the largest element
+	int pivot = 0;
+	for(int i=0;i<(int)kernel.size();i++)
+		if(std::abs(kernel[i])>std::abs(kernel[pivot]))
+			pivot = i;
+	float maxAbs = std::abs(kernel[pivot]);
+	if(maxAbs==0)
+		return false;
+	int py = pivot/size;
+	int px = pivot%size;
+
+	column = std::vector<float>(size);
+	row = std::vector<float>(size);
+	for(int i=0;i<size;i++)
+	{
+		column[i] = kernel[i*size + px];
+		row[i] = kernel[py*size + i]/kernel[pivot];
+	}
+
+	for(int y=0;y<size;y++)
+		for(int x=0;x<size;x++)
+			if(std::abs(kernel[y*size + x]-column[y]*row[x]) > tolerance*maxAbs)
+				return false;
+	return true;
+}
+
+// Only non-negative odd sized kernels can be run in fixed point
+bool makeSeparableKernel(const std::vector<float>& column, const std::vector<float>& row, SeparableKernel& kernel)
+{
+	if(column.size()!=row.size() || column.size()%2==0)
+		return false;
+
+	std::vector<int16_t> qColumn = quantizeKernel(column);
+	std::vector<int16_t> qRow = quantizeKernel(row);
+	if(qColumn.empty() || qRow.empty())
+		return false;
+
+	kernel.column = qColumn;
+	kernel.row = qRow;
+	kernel.radius = column.size()/2;
+	return true;
+}
+
+// Kernel from compile time weights (see gaussianWeights() and boxWeights())
+template<size_t TAPS>
+SeparableKernel makeSeparableKernel(const std::array<int16_t, TAPS>& column, const std::array<int16_t, TAPS>& row)
+{
+	static_assert(TAPS%2==1, "Kernels have an odd size");
+	SeparableKernel kernel;
+	kernel.column.assign(column.begin(), column.end());
+	kernel.row.assign(row.begin(), row.end());
+	kernel.radius = TAPS/2;
+	return kernel;
+}
+
+//--------------------//
+//- Constant kernels -//
+//--------------------//
+// Fixed point weights generated at compile time, like quantizeKernel() the
+// rounding residual goes to the largest weight (the center one for ties)
+template<int RADIUS>
+using FixedWeights = std::array<int16_t, 2*RADIUS+1>;
+
+template<int RADIUS>
+constexpr FixedWeights<RADIUS> quantizeWeights(const std::array<double, 2*RADIUS+1>& weights)
+{
+	double sum = 0;
+	for(double w : weights)
+		sum += w;
+
+	const int one = 1<<BLUR_WEIGHT_BITS;
+	FixedWeights<RADIUS> result{};
+	int total = 0;
+	int largest = RADIUS;
+	for(int i=0;i<2*RADIUS+1;i++)
+	{
+		result[i] = int16_t(weights[i]/sum*one + 0.5);
+		total += result[i];
+		if(weights[i]>weights[largest])
+			largest = i;
+	}
+	result[largest] += one-total;
+	return result;
+}
+
+// e^x for x<=0 (std::exp is not constexpr): Taylor series of x halved until
+// it is small, squared back as many times
+constexpr double constexprExp(double x)
+{
+	int halvings = 0;
+	while(x<-0.5)
+	{
+		x /= 2;
+		halvings++;
+	}
+	double term = 1;
+	double sum = 1;
+	for(int i=1;i<16;i++)
+	{
+		term *= x/i;
+		sum += term;
+	}
+	for(int i=0;i<halvings;i++)
+		sum *= sum;
+	return sum;
+}
+
+template<int RADIUS>
+constexpr FixedWeights<RADIUS> gaussianWeights(double sigma)
+{
+	std::array<double, 2*RADIUS+1> weights{};
+	for(int i=-RADIUS;i<=RADIUS;i++)
+		weights[i+RADIUS] = constexprExp(-i*i/(2*sigma*sigma));
+	return quantizeWeights<RADIUS>(weights);
+}
+
+template<int RADIUS>
+constexpr FixedWeights<RADIUS> boxWeights()
+{
+	std::array<double, 2*RADIUS+1> weights{};
+	for(auto& w : weights)
+		w = 1;
+	return quantizeWeights<RADIUS>(weights);
+}
+
+//--------------------//
+//------ Passes ------//
+//--------------------//
+// TAPS (and STEP) are the tap count (and channel count) when known at compile
+// time, 0 otherwise: with constants the loops over the taps are unrolled and
+// the weights stay in registers.
+// Vertical pass: out[i] = sum_k w[k]*rows[k][i]
+template<int TAPS=0>
+void blurColumnScalar(const unsigned char* const* rows, const int16_t* w, int taps, int n, uint16_t* out, int start=0)
+{
+	taps = TAPS>0 ? TAPS : taps;
+	for(int i=start;i<n;i++)
+	{
+		int sum=0;
+		for(int k=0;k<taps;k++)
+			sum += w[k]*rows[k][i];
+		out[i] = sum;
+	}
+}
+
+// Horizontal pass: out[i] = round(sum_k w[k]*in[i+k*step]), step is the channel count
+template<int TAPS=0, int STEP=0>
+void blurRowScalar(const uint16_t* in, const int16_t* w, int taps, int step, int n, unsigned char* out, int start=0)
+{
+	taps = TAPS>0 ? TAPS : taps;
+	step = STEP>0 ? STEP : step;
+	const int round = 1<<(2*BLUR_WEIGHT_BITS-1);
+	for(int i=start;i<n;i++)
+	{
+		int sum=0;
+		for(int k=0;k<taps;k++)
+			sum += w[k]*in[i+k*step];
+		out[i] = (sum+round)>>(2*BLUR_WEIGHT_BITS);
+	}
+}
+
+template<int TAPS=0>
+void blurColumn(const unsigned char* const* rows, const int16_t* w, int taps, int n, uint16_t* out)
+{
+	// A local copy can not alias out, so the compiler keeps constant weights in registers
+	int16_t weights[TAPS>0 ? TAPS : 1];
+	if(TAPS>0)
+	{
+		std::copy(w, w+TAPS, weights);
+		w = weights;
+		taps = TAPS;
+	}
+
+	int i=0;
+#if defined(__AVX2__)
+	for(;i+16<=n;i+=16)
+	{
+		__m256i sum = _mm256_setzero_si256();
+		for(int k=0;k<taps;k++)
+		{
+			__m256i v = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)(rows[k]+i)));
+			sum = _mm256_add_epi16(sum, _mm256_mullo_epi16(v, _mm256_set1_epi16(w[k])));
+		}
+		_mm256_storeu_si256((__m256i*)(out+i), sum);
+	}
+#elif defined(__SSE2__)
+	const __m128i zero = _mm_setzero_si128();
+	for(;i+8<=n;i+=8)
+	{
+		__m128i sum = _mm_setzero_si128();
+		for(int k=0;k<taps;k++)
+		{
+			__m128i v = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(rows[k]+i)), zero);
+			sum = _mm_add_epi16(sum, _mm_mullo_epi16(v, _mm_set1_epi16(w[k])));
+		}
+		_mm_storeu_si128((__m128i*)(out+i), sum);
+	}
+#endif
+	blurColumnScalar<TAPS>(rows, w, taps, n, out, i);
+}
+
+template<int TAPS=0, int STEP=0>
+void blurRow(const uint16_t* in, const int16_t* w, int taps, int step, int n, unsigned char* out)
+{
+	int16_t weights[TAPS>0 ? TAPS : 1];
+	if(TAPS>0)
+	{
+		std::copy(w, w+TAPS, weights);
+		w = weights;
+		taps = TAPS;
+	}
+	step = STEP>0 ? STEP : step;
+
+	int i=0;
+	// Column sums are at most 255<<BLUR_WEIGHT_BITS, so they are valid signed madd operands
+#if defined(__AVX2__)
+	const __m256i round = _mm256_set1_epi32(1<<(2*BLUR_WEIGHT_BITS-1));
+	for(;i+8<=n;i+=8)
+	{
+		__m256i sum = round;
+		for(int k=0;k<taps;k++)
+		{
+			__m256i v = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*)(in+i+k*step)));
+			sum = _mm256_add_epi32(sum, _mm256_madd_epi16(v, _mm256_set1_epi32(w[k])));
+		}
+		sum = _mm256_srai_epi32(sum, 2*BLUR_WEIGHT_BITS);
+		__m128i packed = _mm_packs_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+		_mm_storel_epi64((__m128i*)(out+i), _mm_packus_epi16(packed, packed));
+	}
+#elif defined(__SSE2__)
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i round = _mm_set1_epi32(1<<(2*BLUR_WEIGHT_BITS-1));
+	for(;i+8<=n;i+=8)
+	{
+		__m128i sumLo = round;
+		__m128i sumHi = round;
+		for(int k=0;k<taps;k++)
+		{
+			__m128i v = _mm_loadu_si128((const __m128i*)(in+i+k*step));
+			__m128i weight = _mm_set1_epi32(w[k]);
+			sumLo = _mm_add_epi32(sumLo, _mm_madd_epi16(_mm_unpacklo_epi16(v, zero), weight));
+			sumHi = _mm_add_epi32(sumHi, _mm_madd_epi16(_mm_unpackhi_epi16(v, zero), weight));
+		}
+		sumLo = _mm_srai_epi32(sumLo, 2*BLUR_WEIGHT_BITS);
+		sumHi = _mm_srai_epi32(sumHi, 2*BLUR_WEIGHT_BITS);
+		__m128i packed = _mm_packs_epi32(sumLo, sumHi);
+		_mm_storel_epi64((__m128i*)(out+i), _mm_packus_epi16(packed, packed));
+	}
+#endif
+	blurRowScalar<TAPS, STEP>(in, w, taps, step, n, out, i);
+}
+
+//--------------------//
+//------- Blur -------//
+//--------------------//
+// Rows [y0,y1) of separableConvolution(), TAPS and CHANNELS as in blurRow().
+// The row buffers are allocated in the arena.
+template<int TAPS=0, int CHANNELS=0>
+void separableConvolutionRows(ConstImageView image, ImageView result, const SeparableKernel& kernel, bool simd, int y0, int y1,
+		FrameArena& arena)
+{
+	int taps = TAPS>0 ? TAPS : 2*kernel.radius+1;
+	int channels = CHANNELS>0 ? CHANNELS : image.channels;
+	int rowSize = image.width*channels;
+	int resultRowSize = result.width*channels;
+	uint16_t* columnSums = arena.allocate<uint16_t>(rowSize);
+	const unsigned char** rows = arena.allocate<const unsigned char*>(taps);
+	for(int yr=y0;yr<y1;yr++)
+	{
+		for(int k=0;k<taps;k++)
+			rows[k] = image.row(yr+k);
+
+		unsigned char* out = result.row(yr);
+		if(simd)
+		{
+			blurColumn<TAPS>(rows, kernel.column.data(), taps, rowSize, columnSums);
+			blurRow<TAPS, CHANNELS>(columnSums, kernel.row.data(), taps, channels, resultRowSize, out);
+		}
+		else
+		{
+			blurColumnScalar<TAPS>(rows, kernel.column.data(), taps, rowSize, columnSums);
+			blurRowScalar<TAPS, CHANNELS>(columnSums, kernel.row.data(), taps, channels, resultRowSize, out);
+		}
+	}
+}
+
+typedef void (*SeparableRows)(ConstImageView, ImageView, const SeparableKernel&, bool, int, int, FrameArena&);
+
+template<int CHANNELS>
+SeparableRows separableRowsFor(int radius)
+{
+	switch(radius)
+	{
+		case 1: return separableConvolutionRows<3, CHANNELS>;
+		case 2: return separableConvolutionRows<5, CHANNELS>;
+		case 3: return separableConvolutionRows<7, CHANNELS>;
+		default: return separableConvolutionRows<0, CHANNELS>;
+	}
+}
+
+// Specialized rows for the usual kernels (3x3, 5x5 and 7x7 on 1 or 3 channels),
+// generic ones for anything else
+SeparableRows separableRowsFor(int radius, int channels)
+{
+	if(channels==1)
+		return separableRowsFor<1>(radius);
+	if(channels==3)
+		return separableRowsFor<3>(radius);
+	return separableConvolutionRows<0, 0>;
+}
+
+// Same output size as convolution(): the border of size radius is cropped
+void separableConvolution(ConstImageView image, ImageView result, const SeparableKernel& kernel, FrameArena& arena, bool simd=true,
+		int numThreads=1)
+{
+	int r = kernel.radius;
+	if((int)image.width<=2*r || (int)image.height<=2*r ||
+		result.width!=image.width-r*2 || result.height!=image.height-r*2 || result.channels!=image.channels)
+	{
+		std::cout << "[separableConvolution] Incompatible images. Nothing done" << std::endl;
+		return;
+	}
+
+	// Each band reads radius rows above and below it (halo)
+	SeparableRows rows = separableRowsFor(r, image.channels);
+	parallelRows(result.height, numThreads, [&](int y0, int y1)
+	{
+		rows(image, result, kernel, simd, y0, y1, arena);
+	});
+}
+
+Image separableConvolution(const Image& image, const SeparableKernel& kernel, bool simd=true, int numThreads=1)
+{
+	int r = kernel.radius;
+	if((int)image.width<=2*r || (int)image.height<=2*r)
+		return Image();
+
+	FrameArena arena;
+	Image result = createImage(image.width-r*2, image.height-r*2, image.channels);
+	separableConvolution(image.view(), result.view(), kernel, arena, simd, numThreads);
+	return result;
+}
+
+// Scalar reference, the SIMD path must match it bit by bit
+Image separableConvolutionScalar(const Image& image, const SeparableKernel& kernel)
+{
+	return separableConvolution(image, kernel, false);
+}
+
+#endif// BLUR_H
@@ -0,0 +1,389 @@
+//--------------------------------------------------
+// Robot Simulator
+// contour.hpp
+// Date: 17/10/2026
+// By Breno Cunha Queiroz
+//--------------------------------------------------
+#ifndef CONTOUR_H
+#define CONTOUR_H
+#include <vector>
+#include <cmath>
+#include <cstdint>
+#include <algorithm>
+#include "helpers.hpp"
+#include "arena.hpp"
+#include "quadFilter.hpp"
+#include "profiler.hpp"
+
+struct ContourPoint
+{
+	int x;
+	int y;
+};
+
+// Border of a blob: points [start,start+count) of the point list, in tracing order
+struct Contour
+{
+	int start = 0;
+	int count = 0;
+	bool hole = false;// Border of a hole of the blob, outer border otherwise
+};
+
+//--------------------//
+//- Border following -//
+//--------------------//
+// Pixel map of followBorders(): the marks of Suzuki and Abe without the border
+// numbers (there is no hierarchy), so it takes one byte per pixel
+enum BorderMark : uint8_t
+{
+	BORDER_BACKGROUND = 0,
+	BORDER_UNVISITED = 1,
+	BORDER_VISITED = 2,
+	BORDER_EAST = 3// Visited, with background on its east side
+};
+
+// Suzuki-Abe border following ("Topological structural analysis of digitized
+// binary images by border following", 1985) over the pixels equal to
+// foreground, 8-connected. Every outer and hole border is traced once in a
+// single raster scan, each one is passed to visit(points, count, hole) in a
+// buffer reused by the next one. The cost is linear in the pixels plus the
+// border lengths. The map and the buffer are allocated in the arena.
+template<typename Visitor>
+void followBorders(ConstImageView binary, unsigned char foreground, FrameArena& arena, const Visitor& visit)
+{
+	int width = binary.width;
+	int height = binary.height;
+	int stride = width+2;
+
+	// A background frame around the image, the neighbors are never out of bounds
+	uint8_t* map = arena.allocate<uint8_t>(size_t(stride)*(height+2));
+	std::fill(map, map+stride, BORDER_BACKGROUND);
+	std::fill(map+size_t(stride)*(height+1), map+size_t(stride)*(height+2), BORDER_BACKGROUND);
+	for(int y=0;y<height;y++)
+	{
+		const unsigned char* src = binary.row(y);
+		uint8_t* dst = map + size_t(y+1)*stride;
+		dst[0] = dst[width+1] = BORDER_BACKGROUND;
+		for(int x=0;x<width;x++)
+			dst[x+1] = src[x]==foreground ? BORDER_UNVISITED : BORDER_BACKGROUND;
+	}
+
+	// Neighbors clockwise on screen, starting from the east one (twice, so the
+	// search below never wraps around)
+	const int offsets[16] = {1, stride+1, stride, stride-1, -1, -stride-1, -stride, -stride+1,
+		1, stride+1, stride, stride-1, -1, -stride-1, -stride, -stride+1};
+	const int dx[8] = {1, 1, 0, -1, -1, -1, 0, 1};
+	const int dy[8] = {0, 1, 1, 1, 0, -1, -1, -1};
+	ArenaVector<ContourPoint> points(arena, 1024);
+	for(int y=1;y<=height;y++)
+	{
+		uint8_t* row = map + size_t(y)*stride;
+		for(int x=1;x<=width;x++)
+		{
+			// Border starts: background on the west of an unvisited pixel, or on
+			// the east of a pixel not already left by a border on that side
+			uint8_t value = row[x];
+			if(value==BORDER_BACKGROUND)
+				continue;
+			bool outer = value==BORDER_UNVISITED && row[x-1]==BORDER_BACKGROUND;
+			bool hole = !outer && value!=BORDER_EAST && row[x+1]==BORDER_BACKGROUND;
+			if(!outer && !hole)
+				continue;
+
+			// First foreground neighbor, clockwise from the background one
+			int start = y*stride + x;
+			int from = outer ? 4 : 0;
+			int first = -1;
+			for(int k=0;k<8 && first<0;k++)
+				if(map[start+offsets[(from+k)&7]]!=BORDER_BACKGROUND)
+					first = (from+k)&7;
+			points.clear();
+			if(first<0)
+			{
+				// Isolated pixel
+				row[x] = BORDER_EAST;
+				points.push_back({x-1, y-1});
+				visit(points.data(), 1, hole);
+				continue;
+			}
+
+			int second = start+offsets[first];
+			int current = start;
+			int cx = x, cy = y;
+			int previous = first;// Direction from current to the previous border pixel
+			while(true)
+			{
+				// Next border pixel, counterclockwise from the previous one (which is
+				// foreground). The east neighbor is index 8 of the search.
+				int d = previous+8;
+				bool eastBackground = false;
+				while(map[current+offsets[--d]]==BORDER_BACKGROUND)
+					eastBackground = eastBackground || d==8;
+				d &= 7;
+
+				if(eastBackground)
+					map[current] = BORDER_EAST;
+				else if(map[current]==BORDER_UNVISITED)
+					map[current] = BORDER_VISITED;
+				points.push_back({cx-1, cy-1});
+
+				// Back at the start, about to take the first step again
+				int next = current+offsets[d];
+				if(next==start && current==second)
+					break;
+				current = next;
+				cx += dx[d];
+				cy += dy[d];
+				previous = (d+4)&7;
+			}
+			visit(points.data(), points.size(), hole);
+		}
+	}
+}
+
+// Every border of the foreground blobs, their points are appended to points
+void traceContours(ConstImageView binary, unsigned char foreground, ArenaVector<ContourPoint>& points,
+		ArenaVector<Contour>& contours, FrameArena& arena)
+{
+	points.clear();
+	contours.clear();
+	followBorders(binary, foreground, arena, [&](const ContourPoint* border, int count, bool hole)
+	{
+		Contour contour;
+		contour.start = points.size();
+		contour.count = count;
+		contour.hole = hole;
+		for(int i=0;i<count;i++)
+			points.push_back(border[i]);
+		contours.push_back(contour);
+	});
+}
+
+std::vector<std::vector<ContourPoint>> traceContours(const Image& binary, unsigned char foreground)
+{
+	FrameArena arena;
+	std::vector<std::vector<ContourPoint>> contours;
+	followBorders(binary.view(), foreground, arena, [&](const ContourPoint* border, int count, bool)
+	{
+		contours.emplace_back(border, border+count);
+	});
+	return contours;
+}
+
+//--------------------//
+//---- Simplifying ---//
+//--------------------//
+#define MAX_POLYGON_VERTICES 16
+
+// Douglas-Peucker on a closed contour: fills vertices with the indices of the
+// kept points in contour order and returns their count, or 0 as soon as more
+// than maxVertices (at most MAX_POLYGON_VERTICES) would be needed, so a
+// contour which is not a polygon with few sides is given up early.
+int simplifyContour(const ContourPoint* points, int count, float epsilon, int maxVertices, int* vertices)
+{
+	maxVertices = std::min(maxVertices, MAX_POLYGON_VERTICES);
+	if(count<3)
+		return 0;
+	auto distance2 = [&](int i, int j)
+	{
+		float x = points[i].x-points[j].x;
+		float y = points[i].y-points[j].y;
+		return x*x+y*y;
+	};
+
+	// Split at two far apart points: the farthest one from the first point and
+	// the farthest one from it. Positions past count wrap around the contour.
+	int a = 0;
+	for(int i=1;i<count;i++)
+		if(distance2(i, 0)>distance2(a, 0))
+			a = i;
+	int b = a;
+	for(int i=0;i<count;i++)
+		if(distance2(i, a)>distance2(b, a))
+			b = i;
+	if(b==a)
+		return 0;
+	if(b<a)
+		b += count;
+
+	int kept[MAX_POLYGON_VERTICES+1] = {a, b};
+	int keptCount = 2;
+	int stack[2*(MAX_POLYGON_VERTICES+2)] = {a, b, b, a+count};
+	int stackSize = 2;
+	float epsilon2 = epsilon*epsilon;
+	while(stackSize>0)
+	{
+		stackSize--;
+		int first = stack[2*stackSize];
+		int last = stack[2*stackSize+1];
+		const ContourPoint& p0 = points[first%count];
+		const ContourPoint& p1 = points[last%count];
+		float lx = p1.x-p0.x;
+		float ly = p1.y-p0.y;
+
+		// Farthest point from the chord, compared as cross products (length² epsilon²)
+		float farthest = 0;
+		int split = -1;
+		for(int i=first+1;i<last;i++)
+		{
+			const ContourPoint& p = points[i%count];
+			float cross = std::abs(lx*(p.y-p0.y) - ly*(p.x-p0.x));
+			if(cross>farthest)
+			{
+				farthest = cross;
+				split = i;
+			}
+		}
+		if(split<0 || farthest*farthest<=epsilon2*(lx*lx+ly*ly))
+			continue;
+
+		if(keptCount==maxVertices)
+			return 0;
+		kept[keptCount++] = split;
+		stack[2*stackSize] = first;
+		stack[2*stackSize+1] = split;
+		stack[2*stackSize+2] = split;
+		stack[2*stackSize+3] = last;
+		stackSize += 2;
+	}
+
+	std::sort(kept, kept+keptCount);
+	for(int i=0;i<keptCount;i++)
+		vertices[i] = kept[i]%count;
+	return keptCount;
+}
+
+//--------------------//
+//---- Quadrangles ---//
+//--------------------//
+// Total least squares line through the points [first,last) of a closed contour
+// (indices wrap around), with the ends of the range skipped: they bend into
+// the neighboring sides. Falls back to the chord when there are too few points.
+void fitContourSide(const ContourPoint* points, int count, int first, int last, Point& center, Point& direction)
+{
+	if(last<first)
+		last += count;
+	int length = last-first;
+	int skip = length*15/100;
+	double sx=0, sy=0, sxx=0, syy=0, sxy=0;
+	int n = 0;
+	for(int i=first+skip;i<=last-skip;i++)
+	{
+		const ContourPoint& p = points[i%count];
+		sx += p.x;
+		sy += p.y;
+		sxx += double(p.x)*p.x;
+		syy += double(p.y)*p.y;
+		sxy += double(p.x)*p.y;
+		n++;
+	}
+	const ContourPoint& a = points[first%count];
+	const ContourPoint& b = points[last%count];
+	if(n<5)
+	{
+		float dx = b.x-a.x;
+		float dy = b.y-a.y;
+		float norm = std::sqrt(dx*dx+dy*dy);
+		center = {(a.x+b.x)/2.f, (a.y+b.y)/2.f};
+		direction = {dx/norm, dy/norm};
+		return;
+	}
+	double cx = sx/n;
+	double cy = sy/n;
+	double xx = sxx/n-cx*cx;
+	double yy = syy/n-cy*cy;
+	double xy = sxy/n-cx*cy;
+	double angle = 0.5*atan2(2*xy, xx-yy);
+	center = {float(cx), float(cy)};
+	direction = {float(cos(angle)), float(sin(angle))};
+}
+
+// Convex 4-gons among the outer borders of the foreground blobs. Contours are
+// simplified with a tolerance of 3% of their length, the sides of the 4-gons
+// are refitted on their border points and the corners intersected, then they
+// go through the quadrangle stages of findQuadrangles(). Blobs touching the
+// image border are skipped. Corners are on the border pixels (the foreground
+// side of the edge), in binary image coordinates.
+void findContourQuadrangles(ConstImageView binary, unsigned char foreground, std::vector<Quadrangle>& result,
+		FrameArena& arena, const QuadFilter& filter=QuadFilter(), QuadStats* stats=nullptr)
+{
+	result.clear();
+	QuadStats counters;
+	long contours = 0;
+	int width = binary.width;
+	int height = binary.height;
+
+	followBorders(binary, foreground, arena, [&](const ContourPoint* points, int count, bool hole)
+	{
+		contours++;
+		// Diagonal steps are sqrt(2) long at most
+		if(hole || count*1.415f<filter.minPerimeter)
+		{
+			counters.size += !hole;
+			return;
+		}
+		for(int i=0;i<count;i++)
+			if(points[i].x==0 || points[i].y==0 || points[i].x==width-1 || points[i].y==height-1)
+			{
+				counters.border++;
+				return;
+			}
+
+		int vertices[4];
+		if(simplifyContour(points, count, 0.03f*count, 4, vertices)!=4)
+		{
+			counters.polygon++;
+			return;
+		}
+
+		Point centers[4];
+		Point directions[4];
+		for(int i=0;i<4;i++)
+			fitContourSide(points, count, vertices[i], vertices[(i+1)%4], centers[i], directions[i]);
+		Point corners[4];
+		for(int i=0;i<4;i++)
+		{
+			// Corner i is between side i-1 and side i
+			const Point& c0 = centers[(i+3)%4];
+			const Point& d0 = directions[(i+3)%4];
+			const Point& c1 = centers[i];
+			const Point& d1 = directions[i];
+			float det = d0.x*d1.y - d0.y*d1.x;
+			if(std::abs(det)<1e-3f)
+			{
+				counters.degenerate++;
+				return;
+			}
+			float t = ((c1.x-c0.x)*d1.y - (c1.y-c0.y)*d1.x)/det;
+			corners[i] = {c0.x+t*d0.x, c0.y+t*d0.y};
+		}
+
+		if(!passesConvexity(corners))
+			counters.convexity++;
+		else if(!passesSize(corners, filter))
+			counters.size++;
+		else if(!passesAspectRatio(corners, filter))
+			counters.aspectRatio++;
+		else
+		{
+			counters.accepted++;
+			result.push_back({corners[0], corners[1], corners[2], corners[3]});
+		}
+	});
+
+	PROFILE_COUNT(PROFILE_CONTOURS, contours);
+	PROFILE_COUNT(PROFILE_QUADS, result.size());
+	if(stats!=nullptr)
+		stats->merge(counters);
+}
+
+std::vector<Quadrangle> findContourQuadrangles(const Image& binary, unsigned char foreground,
+		const QuadFilter& filter=QuadFilter(), QuadStats* stats=nullptr)
+{
+	FrameArena arena;
+	std::vector<Quadrangle> result;
+	findContourQuadrangles(binary.view(), foreground, result, arena, filter, stats);
+	return result;
+}
+
+#endif// CONTOUR_H
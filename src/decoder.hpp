@@ -0,0 +1,491 @@
+//--------------------------------------------------
+// Robot Simulator
+// decoder.hpp
+// Date: 17/10/2026
+// By Breno Cunha Queiroz
+//--------------------------------------------------
+#ifndef DECODER_H
+#define DECODER_H
+#include <vector>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <algorithm>
+#include <iterator>
+#include "helpers.hpp"
+#include "homography.hpp"
+#include "detector.hpp"
+#include "arena.hpp"
+
+// Codes are 64 bit, so side is at most 8, and the grid with its border is at most 10 cells
+#define TAG_MAX_CELLS 10
+
+// A random grid (e.g. clutter inside a quadrangle) is accepted with a probability under 2^-TAG_FALSE_ACCEPT_BITS
+#define TAG_FALSE_ACCEPT_BITS 20
+
+// Square tag: a black border of border cells around side x side code bits. Bit
+// (row*side+col) set means a white cell, rows go from p0 to p3, columns from p0 to p1.
+struct TagFamily
+{
+	int side = 6;
+	int border = 2;
+	int minDistance = 11;// Hamming distance between any two codes, rotations included
+	std::vector<uint64_t> codes;
+
+	int cells() const { return side+2*border; }
+
+	// Up to (minDistance-1)/2 bits, fewer when the observable codes (every
+	// rotation with every flip) would be too large a part of the code space:
+	// with few bits a random grid would decode too often
+	int correctable() const
+	{
+		int bits = side*side;
+		double observable = 4.0*codes.size();
+		double flips = 1;
+		int errors = 0;
+		for(int k=1;k<=(minDistance-1)/2;k++)
+		{
+			flips = flips*(bits-k+1)/k;// Binomial (bits, k)
+			observable += 4.0*codes.size()*flips;
+			if(observable>std::ldexp(1.0, bits-TAG_FALSE_ACCEPT_BITS))
+				break;
+			errors = k;
+		}
+		return errors;
+	}
+};
+
+// Code rotated 90 degrees clockwise
+uint64_t rotateCode(uint64_t code, int side)
+{
+	uint64_t result = 0;
+	for(int row=0;row<side;row++)
+		for(int col=0;col<side;col++)
+			if((code>>((side-1-col)*side + row))&1)
+				result |= uint64_t(1)<<(row*side + col);
+	return result;
+}
+
+int hammingDistance(uint64_t a, uint64_t b)
+{
+	return __builtin_popcountll(a^b);
+}
+
+// Greedy search in a fixed order: the whole code space in a scrambled order up
+// to side 4, the first candidates of a splitmix64 sequence above. Codes are
+// kept when every rotation is at least minDistance from the codes already
+// taken and from its own other rotations. Codes with too few white or black
+// cells are skipped, they look like plain squares.
+TagFamily makeTagFamily(int side=6, int minDistance=11, int border=2, uint64_t candidates=100000)
+{
+	TagFamily family;
+	family.side = side;
+	family.border = border;
+	family.minDistance = minDistance;
+	if(side<1 || border<1 || side+2*border>TAG_MAX_CELLS)
+	{
+		std::cout << "[makeTagFamily] The grid should have at most " << TAG_MAX_CELLS << " cells. Nothing done" << std::endl;
+		return family;
+	}
+
+	int bits = side*side;
+	uint64_t mask = bits==64 ? ~uint64_t(0) : (uint64_t(1)<<bits)-1;
+	uint64_t count = side<=4 ? uint64_t(1)<<bits : candidates;
+	uint64_t state = 0;
+	std::vector<uint64_t> taken;// All the rotations of the codes
+	for(uint64_t i=0;i<count;i++)
+	{
+		uint64_t code;
+		if(side<=4)
+			code = (i*40503 + 12345)&mask;// Odd multiplier, so a permutation
+		else
+		{
+			state += 0x9E3779B97F4A7C15ull;
+			code = state;
+			code = (code^(code>>30))*0xBF58476D1CE4E5B9ull;
+			code = (code^(code>>27))*0x94D049BB133111EBull;
+			code = (code^(code>>31))&mask;
+		}
+		int ones = __builtin_popcountll(code);
+		if(ones<bits/4 || ones>bits-bits/4)
+			continue;
+
+		uint64_t rotations[4] = {code};
+		for(int q=1;q<4;q++)
+			rotations[q] = rotateCode(rotations[q-1], side);
+		bool valid = true;
+		for(int q=1;q<4 && valid;q++)
+			valid = hammingDistance(code, rotations[q])>=minDistance;
+		for(size_t k=0;k<taken.size() && valid;k++)
+			valid = hammingDistance(code, taken[k])>=minDistance;
+		if(!valid)
+			continue;
+
+		family.codes.push_back(code);
+		taken.insert(taken.end(), rotations, rotations+4);
+	}
+	return family;
+}
+
+// Default family: the codes of makeTagFamily(6, 11, 2), stored to spare the
+// search at startup. 282 codes of 6x6 bits in a 2 cell black border (10x10
+// cells, the layout of ARTag markers), 1 bit corrected. These are not the
+// ARTag codes, whose id encoding is not reproduced: ARTag markers are rejected.
+const uint64_t DEFAULT_TAG_CODES[] =
+{
+	0xaa1b965f4, 0x88009454f, 0x8724c81ec, 0xa51a8749b, 0xe1f4532e1, 0x041c98ac3,
+	0xc368cb0a6, 0xd3cb13d09, 0x0055bdef6, 0x5983aa92f, 0x600cc4d19, 0x7971d80ab,
+	0xc75521255, 0x02b7f7f86, 0x21825f10d, 0x90dca2f6a, 0x67bd2634c, 0xbb45c6316,
+	0xea8e40225, 0x64963bab0, 0x7111ac529, 0xf599dc6f7, 0x3b43343a1, 0x324851729,
+	0x4a792922a, 0x6918175ce, 0xb302278a8, 0x97019e937, 0x652ebf438, 0x1763e79ad,
+	0x6743aae49, 0x7b1a1f2e1, 0xba71a5eb1, 0x20043c714, 0x5dd9e0ec1, 0x9a17b3c8f,
+	0xb1cbbf170, 0x929a88f1d, 0x7b8bb18fb, 0xf3e46f143, 0x399a4fc72, 0xdaed5bdfc,
+	0xc8d8553c0, 0x41d86a66f, 0xeee954551, 0x07441bcd2, 0x4a0ee15b4, 0x296a7eea1,
+	0x60e3335a7, 0x205234c6d, 0x3a6f2b568, 0x639ac2c65, 0x057e00235, 0xdc6589373,
+	0x26dd3aee7, 0x800a05f50, 0x8bb2dc749, 0x7336bd182, 0x764ed82f2, 0x3157c85d0,
+	0xfd20f0841, 0xb86039fe8, 0xf650d04e1, 0xb46980cad, 0x347612dcf, 0x1586d7a91,
+	0xc2acbd1f0, 0xc7d015bf6, 0xd102301eb, 0x81355ef2d, 0x486e29eed, 0x8796893ba,
+	0x32070e652, 0x375704f28, 0xa1e33c095, 0x1552b4f57, 0x80a8a8898, 0x9e50ef3ef,
+	0x8f2b0f37a, 0x1212e37e8, 0x31e81a5fc, 0xab85ed6d8, 0x9e3acc5a3, 0x71d904827,
+	0x2bd9cdee5, 0x7ba00b9cc, 0x6764f4cba, 0x19fd97dc4, 0x5fdf6900b, 0xc3ee276fa,
+	0xe247adf55, 0x1cfd0e893, 0x25ea2d9fe, 0xe26a7a248, 0xa93638d09, 0xf613ba6a7,
+	0xc64aa2138, 0x20936c74f, 0x8e268bc60, 0xf628757d7, 0x749559626, 0x57b6e8645,
+	0xa93326442, 0x8ad75e5be, 0x695dfd347, 0xd7d4bde63, 0xdf2901695, 0x85e907988,
+	0x26a4b65d8, 0xcec9e9974, 0x180037e79, 0xebfc34e9b, 0x6d4844270, 0x0ad892ed4,
+	0x4bf0bbd06, 0xf9c4db5f7, 0x710af973e, 0x7efbf053c, 0x58bc7f5b5, 0x2669711b0,
+	0x41e8ec4b1, 0xcbd650853, 0x5de5dd831, 0xe9dc78bf4, 0x0fc2499ed, 0x13adb6e3b,
+	0x75142a10e, 0xeeb83b16c, 0x6825636b0, 0x7a2d24a3e, 0xd29e3cffb, 0xf853210c5,
+	0x8169dda78, 0x63bfe9035, 0x6b327d60f, 0x4e6ce592b, 0x28a950ba7, 0x3e066e9a3,
+	0xe25c02166, 0xc99a8fac6, 0xac638c89b, 0x02404c37a, 0xd41f61975, 0xcd6ab5de2,
+	0x36d12b328, 0x00285b2b5, 0x9df37bcb4, 0x2d0ca2cf5, 0x69d18e944, 0xbeca82b0e,
+	0xe1ddd8ca1, 0x68e40e5a9, 0x8f19bfa18, 0x0cec53cf7, 0x6667dbc1f, 0xc305509d4,
+	0xd88b2469a, 0x84d560b9d, 0x21af1d60b, 0x64399854b, 0xcece11b1d, 0xd43db2cc8,
+	0x621aaf456, 0xccd3ac37e, 0x7cf9a3cbb, 0x40503edb3, 0xdae2d9287, 0x02e696a65,
+	0x7f77128a6, 0x04b0af62f, 0x82a49328a, 0xddc61a50f, 0xa0455d49f, 0xaa3da9cfc,
+	0x45693937d, 0xf660878dd, 0x247b5437c, 0x73525be9b, 0x89e69aca3, 0x22a39691f,
+	0xddb521aad, 0x527e87288, 0xdc6bc339a, 0x633152367, 0x53e1c5350, 0x384a33c8c,
+	0x195c40fe7, 0x567be3814, 0x3d0601ac0, 0x3adda9016, 0xb3773a20e, 0xbf44e1aac,
+	0x51bac1442, 0x8c9e4560c, 0x87c8c2242, 0x99af7bbcf, 0xa262d8334, 0x163c113bb,
+	0x1d40beccd, 0xe8721d5b4, 0xc4dd3f580, 0xf89dfdabd, 0xb91677751, 0x5b8f77f70,
+	0x2c8b68d3d, 0x04364b502, 0xc7e4a617f, 0xd511d0b68, 0x437fa4c77, 0xfd0dad827,
+	0x52e8eba4b, 0xcb2ec4fc4, 0x47dede8e9, 0xac659a8c4, 0x94a9fe46b, 0x78bbfb932,
+	0xca1daab4c, 0x077a8a85b, 0xa58f6be45, 0x1ee8dea72, 0x782bd5591, 0xeb51ba6d0,
+	0x4d70033c4, 0x24e3056ba, 0x525d8ea34, 0x8d36ec2e1, 0x2caa4a7cc, 0x249272724,
+	0x2bbb5043b, 0x7f6669df0, 0x5cc94c78f, 0xb01bdbd40, 0x99d31cb62, 0xd94914d9c,
+	0x4eb119e4c, 0x61d58106a, 0x9816781b0, 0x3646861fe, 0x220c8f7bf, 0xc75b5ac76,
+	0xed94d7b5c, 0xeaa8d3704, 0x941dcbaa5, 0xa8eb2731c, 0x42b32b381, 0xafda0b4e4,
+	0xfc61f835c, 0xfcbc08ac6, 0x3b2ae0e3d, 0x93989634c, 0x9405a7e10, 0x6e9b8a158,
+	0xb9cbe8c8b, 0xba7c1ef2b, 0xfe890bccb, 0x483a1c971, 0x8f711573c, 0x58abb0f66,
+	0xce284ec5e, 0xcc8f2b22e, 0x8408d2411, 0x45a14fdbf, 0x7097f30e3, 0xe4cb96408,
+	0x76b9932c5, 0x100eea4af, 0x35e5fee97, 0x4a1df7cfb, 0xa847b23c3, 0x216fb6dbd,
+	0x1e5f3e67e, 0xc04a608e0, 0x57b7d6c58, 0x6e0b726d6, 0xa67269433, 0x1564cb670,
+	0xa420b1f19, 0xecdfa79f2, 0x5602b2ad8, 0x5555ddb8b, 0x05f4cfb57, 0x0caae6947,
+};
+
+const TagFamily& defaultTagFamily()
+{
+	static const TagFamily family = {6, 2, 11, std::vector<uint64_t>(std::begin(DEFAULT_TAG_CODES), std::end(DEFAULT_TAG_CODES))};
+	return family;
+}
+
+struct TagCode
+{
+	int id = -1;
+	int rotation = 0;// Clockwise quarter turns from the canonical code to the observed one
+	int errors = 0;// Bits corrected
+};
+
+// Open addressing hash table from every observable code (the four rotations
+// of each codeword with up to correctable flipped bits) to its decoding, so
+// a lookup is a single probe sequence.
+class TagCodebook
+{
+public:
+	explicit TagCodebook(const TagFamily& family): family(family)
+	{
+		size_t entries = family.codes.size()*4;
+		for(int k=1;k<=family.correctable();k++)
+			entries *= 1 + family.side*family.side;// Upper bound of the flips
+		while(capacity<2*entries)
+		{
+			capacity *= 2;
+			shift--;
+		}
+		keys.assign(capacity, EMPTY);
+		values.resize(capacity);
+
+		for(size_t id=0;id<family.codes.size();id++)
+		{
+			uint64_t code = family.codes[id];
+			for(int q=0;q<4;q++)
+			{
+				TagCode value;
+				value.id = id;
+				value.rotation = q;
+				insertFlips(code, 0, family.correctable(), value);
+				code = rotateCode(code, family.side);
+			}
+		}
+	}
+
+	bool lookup(uint64_t code, TagCode& result) const
+	{
+		for(size_t slot=hash(code);;slot=(slot+1)&(capacity-1))
+		{
+			if(keys[slot]==EMPTY)
+				return false;
+			if(keys[slot]==code)
+			{
+				result = values[slot];
+				return true;
+			}
+		}
+	}
+
+	const TagFamily& tagFamily() const { return family; }
+
+private:
+	static constexpr uint64_t EMPTY = ~uint64_t(0);
+
+	size_t hash(uint64_t code) const
+	{
+		return (code*0x9E3779B97F4A7C15ull)>>shift;
+	}
+
+	// code with every combination of up to remaining flips among bits >= firstBit
+	void insertFlips(uint64_t code, int firstBit, int remaining, TagCode value)
+	{
+		insert(code, value);
+		if(remaining==0)
+			return;
+		value.errors++;
+		for(int bit=firstBit;bit<family.side*family.side;bit++)
+			insertFlips(code^(uint64_t(1)<<bit), bit+1, remaining-1, value);
+	}
+
+	void insert(uint64_t code, const TagCode& value)
+	{
+		size_t slot = hash(code);
+		while(keys[slot]!=EMPTY && keys[slot]!=code)
+			slot = (slot+1)&(capacity-1);
+		// The minimum distance keeps the codewords apart, only the error count can differ
+		if(keys[slot]==code && values[slot].errors<=value.errors)
+			return;
+		keys[slot] = code;
+		values[slot] = value;
+	}
+
+	TagFamily family;
+	size_t capacity = 16;
+	int shift = 60;// 64 - log2(capacity)
+	std::vector<uint64_t> keys;
+	std::vector<TagCode> values;
+};
+
+const TagCodebook& defaultTagCodebook()
+{
+	static TagCodebook codebook(defaultTagFamily());
+	return codebook;
+}
+
+// Quads rejected by each decoding stage
+struct DecodeStats
+{
+	long decoded = 0;
+	long outside = 0;// Quiet zone not inside the image
+	long contrast = 0;// Border not darker than the quiet zone
+	long border = 0;// Border cells not black
+	long code = 0;// Not a codeword
+	long duplicate = 0;
+
+	void merge(const DecodeStats& other)
+	{
+		decoded += other.decoded;
+		outside += other.outside;
+		contrast += other.contrast;
+		border += other.border;
+		code += other.code;
+		duplicate += other.duplicate;
+	}
+};
+
+// Intensity of the cell around (u,v), in cells from the tag corner p0. The
+// center and four points around it are averaged, -1 if one is outside the image.
+int sampleCell(ConstImageView image, const Homography& H, float u, float v)
+{
+	const float offsets[5][2] = {{0, 0}, {-0.2f, -0.2f}, {0.2f, -0.2f}, {-0.2f, 0.2f}, {0.2f, 0.2f}};
+	int channels = std::min((int)image.channels, 3);
+	int sum = 0;
+	for(const auto& offset : offsets)
+	{
+		Point p = H.apply(u+offset[0], v+offset[1]);
+		int x = std::lround(p.x);
+		int y = std::lround(p.y);
+		if(x<0 || y<0 || x>=(int)image.width || y>=(int)image.height)
+			return -1;
+		const unsigned char* pixel = &image.at(x, y);
+		int value = pixel[0];
+		for(int c=1;c<channels;c++)
+			value = std::max(value, (int)pixel[c]);
+		sum += value;
+	}
+	return sum/5;
+}
+
+// Reads the code of one quadrangle (input image coordinates). On success the
+// corners are reordered so that p0 is the top left corner of the canonical tag.
+bool decodeQuadrangle(ConstImageView image, Quadrangle& quad, const TagCodebook& codebook, TagCode& result,
+		DecodeStats* stats=nullptr, int minContrast=20)
+{
+	const TagFamily& family = codebook.tagFamily();
+	int cells = family.cells();
+	int border = family.border;
+	if(cells>TAG_MAX_CELLS)
+		return false;
+
+	// Clockwise on screen, like the code grid
+	Point corners[4] = {quad.p0, quad.p1, quad.p2, quad.p3};
+	float area = 0;
+	for(int i=0;i<4;i++)
+		area += corners[i].x*corners[(i+1)%4].y - corners[(i+1)%4].x*corners[i].y;
+	if(area<0)
+		std::swap(corners[1], corners[3]);
+
+	const Point square[4] = {{0, 0}, {float(cells), 0}, {float(cells), float(cells)}, {0, float(cells)}};
+	Homography H;
+	if(!computeHomography(square, corners, H))
+	{
+		if(stats!=nullptr) stats->outside++;
+		return false;
+	}
+
+	// Quiet zone ring just outside the quad and the black border cells inside
+	int white = 0, whiteCount = 0;
+	int black = 0, blackCount = 0;
+	int borderValues[TAG_MAX_CELLS*TAG_MAX_CELLS];
+	for(int i=-1;i<=cells;i++)
+		for(int j=-1;j<=cells;j++)
+		{
+			bool ring = i==-1 || j==-1 || i==cells || j==cells;
+			bool inBorder = !ring && (i<border || j<border || i>=cells-border || j>=cells-border);
+			if(!ring && !inBorder)
+				continue;
+			int value = sampleCell(image, H, j+0.5f, i+0.5f);
+			if(value<0)
+			{
+				if(stats!=nullptr) stats->outside++;
+				return false;
+			}
+			if(ring)
+			{
+				white += value;
+				whiteCount++;
+			}
+			else
+			{
+				borderValues[blackCount++] = value;
+				black += value;
+			}
+		}
+	white /= whiteCount;
+	black /= blackCount;
+	if(white-black<minContrast)
+	{
+		if(stats!=nullptr) stats->contrast++;
+		return false;
+	}
+	int threshold = (white+black)/2;
+
+	// Cheap rejection before reading the bits, at most one border cell in 16 may be wrong
+	int light = 0;
+	for(int k=0;k<blackCount;k++)
+		light += borderValues[k]>threshold;
+	if(light>blackCount/16)
+	{
+		if(stats!=nullptr) stats->border++;
+		return false;
+	}
+
+	uint64_t code = 0;
+	for(int row=0;row<family.side;row++)
+		for(int col=0;col<family.side;col++)
+			if(sampleCell(image, H, col+border+0.5f, row+border+0.5f)>threshold)
+				code |= uint64_t(1)<<(row*family.side + col);
+	if(!codebook.lookup(code, result))
+	{
+		if(stats!=nullptr) stats->code++;
+		return false;
+	}
+
+	// The canonical top left cell was turned to corner rotation of the observed grid
+	Point* ordered[4] = {&quad.p0, &quad.p1, &quad.p2, &quad.p3};
+	for(int i=0;i<4;i++)
+		*ordered[i] = corners[(i+result.rotation)%4];
+	return true;
+}
+
+// Keeps only the quadrangles that decode, in canonical corner order, and
+// fills detection.ids. The same tag found twice (e.g. at two pyramid
+// alignments) is reported once, with the fewest corrected bits.
+DecodeStats decodeTags(ConstImageView image, Detection& detection, FrameArena& arena, const TagCodebook& codebook=defaultTagCodebook())
+{
+	PROFILE_SCOPE("decode");
+	DecodeStats stats;
+	ArenaVector<Quadrangle> quadrangles(arena, detection.quadrangles.size());
+	ArenaVector<TagCode> codes(arena, detection.quadrangles.size());
+	for(Quadrangle quad : detection.quadrangles)
+	{
+		TagCode code;
+		if(!decodeQuadrangle(image, quad, codebook, code, &stats))
+			continue;
+
+		Point center = {(quad.p0.x+quad.p1.x+quad.p2.x+quad.p3.x)/4, (quad.p0.y+quad.p1.y+quad.p2.y+quad.p3.y)/4};
+		float side = std::hypot(quad.p1.x-quad.p0.x, quad.p1.y-quad.p0.y);
+		bool duplicate = false;
+		for(size_t k=0;k<quadrangles.size() && !duplicate;k++)
+		{
+			const Quadrangle& other = quadrangles[k];
+			Point otherCenter = {(other.p0.x+other.p1.x+other.p2.x+other.p3.x)/4, (other.p0.y+other.p1.y+other.p2.y+other.p3.y)/4};
+			if(codes[k].id!=code.id || std::hypot(center.x-otherCenter.x, center.y-otherCenter.y)>side/4)
+				continue;
+			duplicate = true;
+			if(code.errors<codes[k].errors)
+			{
+				quadrangles[k] = quad;
+				codes[k] = code;
+			}
+		}
+		if(duplicate)
+		{
+			stats.duplicate++;
+			continue;
+		}
+		quadrangles.push_back(quad);
+		codes.push_back(code);
+	}
+
+	detection.quadrangles.assign(quadrangles.begin(), quadrangles.end());
+	detection.ids.resize(codes.size());
+	for(size_t k=0;k<codes.size();k++)
+		detection.ids[k] = codes[k].id;
+	stats.decoded = codes.size();
+	return stats;
+}
+
+DecodeStats decodeTags(ConstImageView image, Detection& detection, const TagCodebook& codebook=defaultTagCodebook())
+{
+	FrameArena arena;
+	return decodeTags(image, detection, arena, codebook);
+}
+
+void printDecodeStats(const DecodeStats& stats)
+{
+	std::cerr << "Tags decoded: " << stats.decoded
+		<< " rejected outside: " << stats.outside
+		<< " contrast: " << stats.contrast
+		<< " border: " << stats.border
+		<< " code: " << stats.code
+		<< " duplicate: " << stats.duplicate << std::endl;
+}
+
+#endif// DECODER_H
@@ -0,0 +1,253 @@
+//--------------------------------------------------
+// Robot Simulator
+// detector.hpp
+// Date: 17/10/2026
+// By Breno Cunha Queiroz
+//--------------------------------------------------
+#ifndef DETECTOR_H
+#define DETECTOR_H
+#include <vector>
+#include "helpers.hpp"
+#include "imgProc.hpp"
+#include "preprocess.hpp"
+#include "pyramid.hpp"
+#include "pose.hpp"
+#include "contour.hpp"
+#include "arena.hpp"
+
+// How the quadrangles are found: 4-cycles in the graph of the lines fitted
+// on the edgels, or convex 4-gons among the borders of the dark blobs of an
+// adaptive threshold (near linear cost, whatever the clutter)
+enum class QuadEngine
+{
+	LINES,
+	CONTOURS
+};
+
+struct Detection
+{
+	std::vector<Quadrangle> quadrangles;// Input image coordinates
+	std::vector<int> ids;// Tag id of each quadrangle once decoded, empty otherwise
+	std::vector<TagPose> poses;// Pose of each quadrangle once estimated, empty otherwise
+	Image edgels;// Only needed to render the detection (the binary image with contours)
+	int border = 0;// Edgel (x,y) is the input pixel (x+border,y+border)...
+	int scale = 1;// ...of the pyramid level scale times smaller than the input
+	QuadStats quadStats;
+};
+
+// Smoothing before the edgels: the 5 tap [1 4 7 4 1]/17 approximation of a
+// gaussian, quantized at compile time (gaussianWeights<2>(1.0) would be
+// [7 31 52 31 7] and move the edgels)
+constexpr FixedWeights<2> DETECTION_WEIGHTS = quantizeWeights<2>({1, 4, 7, 4, 1});
+
+const SeparableKernel& detectionKernel()
+{
+	static const SeparableKernel gaussian = makeSeparableKernel(DETECTION_WEIGHTS, DETECTION_WEIGHTS);
+	return gaussian;
+}
+
+// Scratch memory of the detector, reused frame after frame
+struct DetectorWorkspace
+{
+	FrameArena arena;// Reset by the owner between frames
+	ImagePool images;
+	std::vector<Line> lines;
+	LineGraph graph;
+	std::vector<Image> pyramid;
+};
+
+// Keeps the capacity of the vectors, the edgel image goes back to the pool
+void resetDetection(Detection& detection, DetectorWorkspace& workspace)
+{
+	detection.quadrangles.clear();
+	detection.ids.clear();
+	detection.poses.clear();
+	detection.border = 0;
+	detection.scale = 1;
+	detection.quadStats = QuadStats();
+	workspace.images.release(std::move(detection.edgels));
+}
+
+// Overwrites detection, whose vectors and edgel image are reused
+void detectARtags(ConstImageView image, Detection& detection, DetectorWorkspace& workspace, int numThreads=1)
+{
+	const SeparableKernel& gaussian = detectionKernel();
+	int r = gaussian.radius;
+	resetDetection(detection, workspace);
+	if((int)image.width<=2*r || (int)image.height<=2*r)
+		return;
+
+	// Grayscale, smoothing and edgels in a single pass over the image
+	detection.border = r;
+	detection.edgels = workspace.images.acquire(image.width-2*r, image.height-2*r, 1);
+	{
+		PROFILE_SCOPE("edgels");
+		computeEdgelsFused(image, detection.edgels.view(), gaussian, 20, workspace.arena, numThreads);
+	}
+	{
+		PROFILE_SCOPE("lines");
+		computeLines(detection.edgels.view(), workspace.lines, workspace.arena);
+	}
+	// TODO try to compelete fragmented lines
+	computeQuadrangles(workspace.lines, detection.quadrangles, workspace.graph, workspace.arena, QuadFilter(), &detection.quadStats);
+
+	for(auto& quad : detection.quadrangles)
+		for(Point* p : {&quad.p0, &quad.p1, &quad.p2, &quad.p3})
+		{
+			p->x += r;
+			p->y += r;
+		}
+}
+
+Detection detectARtags(ConstImageView image, int numThreads=1)
+{
+	DetectorWorkspace workspace;
+	Detection detection;
+	detectARtags(image, detection, workspace, numThreads);
+	return detection;
+}
+
+// Contour engine: the dark pixels of an adaptive threshold of the gray image
+// (windows of about 1/16 of the height, from 15 pixels), their outer borders
+// simplified to 4-gons and each side refitted on the gray image edge. The
+// binary image is kept as the edgel image, without border.
+void detectARtagsContours(ConstImageView image, Detection& detection, DetectorWorkspace& workspace, int numThreads=1)
+{
+	resetDetection(detection, workspace);
+	if(image.width<3 || image.height<3)
+		return;
+
+	Image gray;
+	ConstImageView grayView = image;
+	detection.edgels = workspace.images.acquire(image.width, image.height, 1);
+	{
+		PROFILE_SCOPE("binarize");
+		if(image.channels!=1)
+		{
+			gray = workspace.images.acquire(image.width, image.height, 1);
+			grayscaleMax(image, gray.view(), numThreads);
+			grayView = gray.view();
+		}
+		int radius = std::max(7, (int)image.height/32);
+		adaptiveThreshold(grayView, detection.edgels.view(), radius, 15, workspace.arena, numThreads);
+	}
+	{
+		PROFILE_SCOPE("contours");
+		findContourQuadrangles(detection.edgels.view(), 0, detection.quadrangles, workspace.arena, QuadFilter(), &detection.quadStats);
+	}
+	{
+		// The corners are on the dark pixels, the edge is half a pixel further
+		PROFILE_SCOPE("refitSides");
+		for(auto& quad : detection.quadrangles)
+			refineQuadrangle(grayView, quad, 2, workspace.arena);
+	}
+	workspace.images.release(std::move(gray));
+}
+
+void detectARtags(ConstImageView image, Detection& detection, DetectorWorkspace& workspace, QuadEngine engine, int numThreads=1)
+{
+	if(engine==QuadEngine::CONTOURS)
+		detectARtagsContours(image, detection, workspace, numThreads);
+	else
+		detectARtags(image, detection, workspace, numThreads);
+}
+
+// Coarse to fine: quadrangles are found levels times 2x decimated and each of
+// them is refined at full resolution in a band around its sides
+void detectARtagsPyramid(ConstImageView image, int levels, Detection& detection, DetectorWorkspace& workspace, int numThreads=1,
+		QuadEngine engine=QuadEngine::LINES)
+{
+	if(levels<=0)
+	{
+		detectARtags(image, detection, workspace, engine, numThreads);
+		return;
+	}
+
+	{
+		PROFILE_SCOPE("pyramid");
+		buildPyramid(image, levels, workspace.pyramid, workspace.images, workspace.arena, numThreads);
+	}
+	detectARtags(workspace.pyramid.back().view(), detection, workspace, engine, numThreads);
+	detection.scale = 1<<(workspace.pyramid.size()-1);
+
+	PROFILE_SCOPE("refine");
+
+	ConstImageView gray = workspace.pyramid.front().view();
+	float searchRadius = 1.5f*detection.scale;
+	for(auto& quad : detection.quadrangles)
+	{
+		for(Point* p : {&quad.p0, &quad.p1, &quad.p2, &quad.p3})
+			*p = pyramidToInput(*p, detection.scale);
+		refineQuadrangle(gray, quad, searchRadius, workspace.arena);
+	}
+}
+
+Detection detectARtagsPyramid(ConstImageView image, int levels, int numThreads=1, QuadEngine engine=QuadEngine::LINES)
+{
+	DetectorWorkspace workspace;
+	Detection detection;
+	detectARtagsPyramid(image, levels, detection, workspace, numThreads, engine);
+	return detection;
+}
+
+// Detector for a sequence of frames. detect() returns its own detection,
+// valid until the next call; once the buffers have grown to the frame size
+// (after a couple of frames) nothing is allocated anymore. The arena can hold
+// the scratch memory of the later stages of the same frame (e.g. decodeTags).
+class Detector
+{
+public:
+	explicit Detector(int pyramidLevels=0, int numThreads=1, QuadEngine quadEngine=QuadEngine::LINES):
+		levels(pyramidLevels), threads(numThreads), engine(quadEngine) {}
+	Detector(const Detector&) = delete;
+	Detector& operator=(const Detector&) = delete;
+
+	Detection& detect(ConstImageView image)
+	{
+		workspace.arena.reset();
+		detectARtagsPyramid(image, levels, detection, workspace, threads, engine);
+		return detection;
+	}
+
+	FrameArena& arena() { return workspace.arena; }
+
+private:
+	int levels;
+	int threads;
+	QuadEngine engine;
+	DetectorWorkspace workspace;
+	Detection detection;
+};
+
+// Fills detection.poses, the corners should be in the tag order (see decodeTags)
+void estimatePoses(Detection& detection, const CameraIntrinsics& camera, double tagSize)
+{
+	PROFILE_SCOPE("pose");
+	detection.poses.resize(detection.quadrangles.size());
+	estimatePoses(detection.quadrangles.data(), detection.quadrangles.size(), camera, tagSize, detection.poses.data());
+}
+
+// Debug overlay: the edgels with the quadrangles drawn over them
+Image renderDetection(const Detection& detection, int numThreads=1)
+{
+	if(detection.edgels.width==0)
+		return Image();
+	PROFILE_SCOPE("render");
+
+	Image result = createImage(detection.edgels.width, detection.edgels.height, 3);
+	grayscaleToColor(detection.edgels.view(), result.view(), numThreads);
+
+	std::vector<Quadrangle> quadrangles = detection.quadrangles;
+	for(auto& quad : quadrangles)
+		for(Point* p : {&quad.p0, &quad.p1, &quad.p2, &quad.p3})
+		{
+			if(detection.scale>1)
+				*p = {(p->x+0.5f)/detection.scale-0.5f, (p->y+0.5f)/detection.scale-0.5f};
+			p->x -= detection.border;
+			p->y -= detection.border;
+		}
+	drawQuadrangles(result.view(), quadrangles);
+	return result;
+}
+
+#endif// DETECTOR_H
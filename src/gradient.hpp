@@ -0,0 +1,102 @@
+//--------------------------------------------------
+// Robot Simulator
+// gradient.hpp
+// Date: 17/10/2026
+// By Breno Cunha Queiroz
+//--------------------------------------------------
+#ifndef GRADIENT_H
+#define GRADIENT_H
+#include <vector>
+#include <cmath>
+#include <cstdint>
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+// Gradients of 8 bit images are in [-255,255]
+#define GRADIENT_RANGE 511
+
+//--------------------//
+//---- Orientation ---//
+//--------------------//
+// Edgel orientation encoding: atan2 mapped to [-127,127] truncating towards zero,
+// stored modulo 256 (so 0 also means "no edgel")
+unsigned char orientationCodeReference(int dx, int dy)
+{
+	return (unsigned char)(int)(std::atan2(dy, dx)*255./(M_PI*2));
+}
+
+// atan2 is odd in dy, so only the dy>=0 half is stored (dy*GRADIENT_RANGE + dx+255)
+const int8_t* orientationTable()
+{
+	static std::vector<int8_t> table = []()
+	{
+		std::vector<int8_t> values(256*GRADIENT_RANGE);
+		for(int dy=0;dy<=255;dy++)
+			for(int dx=-255;dx<=255;dx++)
+				values[dy*GRADIENT_RANGE + dx+255] = (int8_t)orientationCodeReference(dx, dy);
+		return values;
+	}();
+	return table.data();
+}
+
+unsigned char orientationCode(int dx, int dy, const int8_t* table)
+{
+	if(dy>=0)
+		return (unsigned char)table[dy*GRADIENT_RANGE + dx+255];
+	return (unsigned char)(-table[-dy*GRADIENT_RANGE + dx+255]);
+}
+
+unsigned char orientationCode(int dx, int dy)
+{
+	return orientationCode(dx, dy, orientationTable());
+}
+
+//--------------------//
+//----- Gradient -----//
+//--------------------//
+// dx[x] = row[x]-row[x-1] and dy[x] = row[x]-prevRow[x] for x in [1,width)
+void gradientRow(const unsigned char* row, const unsigned char* prevRow, int width, int16_t* dx, int16_t* dy)
+{
+	int x=1;
+#if defined(__AVX2__)
+	for(;x+16<=width;x+=16)
+	{
+		__m256i now = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)(row+x)));
+		__m256i left = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)(row+x-1)));
+		__m256i up = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)(prevRow+x)));
+		_mm256_storeu_si256((__m256i*)(dx+x), _mm256_sub_epi16(now, left));
+		_mm256_storeu_si256((__m256i*)(dy+x), _mm256_sub_epi16(now, up));
+	}
+#elif defined(__SSE2__)
+	const __m128i zero = _mm_setzero_si128();
+	for(;x+8<=width;x+=8)
+	{
+		__m128i now = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(row+x)), zero);
+		__m128i left = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(row+x-1)), zero);
+		__m128i up = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(prevRow+x)), zero);
+		_mm_storeu_si128((__m128i*)(dx+x), _mm_sub_epi16(now, left));
+		_mm_storeu_si128((__m128i*)(dy+x), _mm_sub_epi16(now, up));
+	}
+#endif
+	for(;x<width;x++)
+	{
+		dx[x] = row[x]-row[x-1];
+		dy[x] = row[x]-prevRow[x];
+	}
+}
+
+// Encode one row of edgels, pixels with both |dx| and |dy| below thresh are left untouched
+void edgelRow(const int16_t* dx, const int16_t* dy, int width, int thresh, unsigned char* out)
+{
+	const int8_t* table = orientationTable();
+	for(int x=1;x<width;x++)
+	{
+		int gx = dx[x];
+		int gy = dy[x];
+		if(gx>thresh || gy>thresh || gx<-thresh || gy<-thresh)
+			out[x] = orientationCode(gx, gy, table);
+	}
+}
+
+#endif// GRADIENT_H
@@ -7,7 +7,6 @@
 #ifndef HELPERS_H
 #define HELPERS_H
 
-#include "svpng/svpng.h"
 #include <iostream>
 #include <array>
 #include <fstream>
@@ -15,10 +14,58 @@
 #include <array>
 #include <vector>
 #include <iterator>
+#include <cstdint>
+#include <cstddef>
+#include <type_traits>
+#include <algorithm>
+#include <climits>
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
 
 //--------------------//
 //------ Image -------//
 //--------------------//
+// Non-owning view of pixels, rows are stride bytes apart (negative for bottom-up buffers)
+template<typename T>
+struct BasicImageView
+{
+	T* data = nullptr;
+	uint32_t width = 0;
+	uint32_t height = 0;
+	int stride = 0;
+	uint8_t channels = 3;
+
+	BasicImageView() = default;
+	BasicImageView(T* data, uint32_t width, uint32_t height, int stride, uint8_t channels):
+		data(data), width(width), height(height), stride(stride), channels(channels) {}
+	// ImageView -> ConstImageView
+	template<typename U, typename = typename std::enable_if<std::is_convertible<U*, T*>::value>::type>
+	BasicImageView(const BasicImageView<U>& other):
+		data(other.data), width(other.width), height(other.height), stride(other.stride), channels(other.channels) {}
+
+	T* row(int y) const { return data + (ptrdiff_t)y*stride; }
+	T& at(int x, int y, int c=0) const { return row(y)[x*channels + c]; }
+	bool contiguous() const { return stride==int(width*channels); }
+
+	// Sub rectangle sharing the same pixels
+	BasicImageView sub(int x, int y, uint32_t w, uint32_t h) const
+	{
+		return BasicImageView(&at(x, y), w, h, stride, channels);
+	}
+};
+typedef BasicImageView<unsigned char> ImageView;
+typedef BasicImageView<const unsigned char> ConstImageView;
+
+template<typename T, typename U>
+bool sameSize(const BasicImageView<T>& a, const BasicImageView<U>& b)
+{
+	return a.width==b.width && a.height==b.height;
+}
+
 struct Image
 {
 	std::vector<unsigned char> buffer;
@@ -30,8 +77,28 @@ struct Image
 	{
 		return buffer[y*width*channels + x*channels + c];
 	}
+
+	ImageView view()
+	{
+		return ImageView(buffer.data(), width, height, width*channels, channels);
+	}
+
+	ConstImageView view() const
+	{
+		return ConstImageView(buffer.data(), width, height, width*channels, channels);
+	}
 };
 
+Image createImage(uint32_t width, uint32_t height, uint8_t channels)
+{
+	Image image;
+	image.width = width;
+	image.height = height;
+	image.channels = channels;
+	image.buffer = std::vector<unsigned char>(width*height*channels);
+	return image;
+}
+
 struct Point
 {
 	float x;
@@ -67,82 +134,170 @@ void populateImage(Image& image)
 }
 
 //--------------------//
-//------- PNG --------//
+//-------- BMP -------//
 //--------------------//
-void writePng(std::string fileName, Image image)
+// Memory mapped BMP file. The pixels are used in place: bottom-up files are
+// exposed through a negative stride view, so nothing is copied or flipped.
+// Supports uncompressed 8 (grayscale palette), 24 and 32 bit files, the
+// channels are in file order (BGR/BGRA).
+class BmpFile
 {
-	Image output;
-	output.width = image.width;
-	output.height = image.height;
-	if(image.channels == 1)
+public:
+	BmpFile() = default;
+	BmpFile(const BmpFile&) = delete;
+	BmpFile& operator=(const BmpFile&) = delete;
+	~BmpFile() { close(); }
+
+	bool open(const std::string& path)
+	{
+		close();
+#if defined(_WIN32)
+		std::ifstream file(path.c_str(), std::ios::binary);
+		if(!file)
+		{
+			std::cout << "[readBmp] Could not open " << path << std::endl;
+			return false;
+		}
+		fileData.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+		data = fileData.data();
+		size = fileData.size();
+#else
+		int fd = ::open(path.c_str(), O_RDONLY);
+		struct stat info;
+		if(fd<0 || fstat(fd, &info)!=0)
+		{
+			if(fd>=0)
+				::close(fd);
+			std::cout << "[readBmp] Could not open " << path << std::endl;
+			return false;
+		}
+		size = info.st_size;
+		void* mapping = size>0 ? mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+		::close(fd);
+		if(mapping==MAP_FAILED)
+		{
+			std::cout << "[readBmp] Could not map " << path << std::endl;
+			size = 0;
+			return false;
+		}
+		data = (const unsigned char*)mapping;
+		madvise(mapping, size, MADV_SEQUENTIAL);
+#endif
+		if(!parse())
+		{
+			std::cout << "[readBmp] Unsupported BMP " << path << std::endl;
+			close();
+			return false;
+		}
+		return true;
+	}
+
+	void close()
 	{
-		output.channels = 3;
-		output.buffer = std::vector<unsigned char>(output.width*output.height*output.channels);
-		for(int y=0;y<image.height;y++)
-			for(int x=0;x<image.width;x++)
-			{
-				unsigned char val = image.buffer[y*image.width + x];
-				output.buffer[y*output.width*output.channels + x*output.channels + 0] = val;
-				output.buffer[y*output.width*output.channels + x*output.channels + 1] = val;
-				output.buffer[y*output.width*output.channels + x*output.channels + 2] = val;
-			}
+#if defined(_WIN32)
+		fileData.clear();
+#else
+		if(data!=nullptr)
+			munmap((void*)data, size);
+#endif
+		data = nullptr;
+		size = 0;
+		pixels = ConstImageView();
 	}
-	else if(image.channels==3 || image.channels==4)
-		output = image;
-	else
-		return;
-
-	// Save png
-	FILE* fp = fopen(("../../output/"+fileName+".png").c_str(), "wb");
-	svpng(fp, output.width, output.height, output.buffer.data(), output.channels==3?0:1);
-	fclose(fp);
-}
 
-//--------------------//
-//-------- BMP -------//
-//--------------------//
-Image readBmp(std::string fileName)
-{
-	Image image;
+	ConstImageView view() const { return pixels; }
 
-	static constexpr size_t HEADER_SIZE = 54;
-	std::string path = std::string("../../gallery/")+fileName+std::string(".bmp");
-	std::ifstream bmp(path.c_str(), std::ios::binary);
-    std::array<char, HEADER_SIZE> header;
-    bmp.read(header.data(), header.size());
+private:
+	template<typename T>
+	T field(size_t offset) const
+	{
+		T value;
+		std::copy(data+offset, data+offset+sizeof(T), (unsigned char*)&value);
+		return value;
+	}
 
-    auto fileSize = *reinterpret_cast<uint32_t *>(&header[2]);
-    auto dataOffset = *reinterpret_cast<uint32_t *>(&header[10]);
-    auto width = *reinterpret_cast<uint32_t *>(&header[18]);
-    auto height = *reinterpret_cast<uint32_t *>(&header[22]);
-    auto depth = *reinterpret_cast<uint16_t *>(&header[28]);
+	bool parse()
+	{
+		static constexpr size_t FILE_HEADER_SIZE = 14;
+		if(size<FILE_HEADER_SIZE+40 || data[0]!='B' || data[1]!='M')
+			return false;
 
-	image.width = width;
-	image.height = height;
-	image.channels = depth/8;
+		uint32_t dataOffset = field<uint32_t>(10);
+		uint32_t infoSize = field<uint32_t>(14);
+		int32_t width = field<int32_t>(18);
+		int32_t height = field<int32_t>(22);
+		uint16_t depth = field<uint16_t>(28);
+		uint32_t compression = field<uint32_t>(30);
+		uint32_t paletteSize = field<uint32_t>(46);
+
+		// BI_RGB, or BI_BITFIELDS with the default 32 bit masks
+		static constexpr uint32_t BI_RGB = 0;
+		static constexpr uint32_t BI_BITFIELDS = 3;
+		if(compression==BI_BITFIELDS)
+		{
+			if(depth!=32 || size<FILE_HEADER_SIZE+40+12 ||
+				field<uint32_t>(54)!=0x00ff0000 || field<uint32_t>(58)!=0x0000ff00 || field<uint32_t>(62)!=0x000000ff)
+				return false;
+		}
+		else if(compression!=BI_RGB)
+			return false;
+		if((depth!=8 && depth!=24 && depth!=32) || width<=0 || height==0 || height==INT32_MIN)
+			return false;
+
+		// Only identity gray palettes can be used in place
+		if(depth==8)
+		{
+			size_t palette = FILE_HEADER_SIZE+infoSize;
+			int entries = paletteSize==0 ? 256 : paletteSize;
+			if(entries>256 || palette+entries*4>dataOffset)
+				return false;
+			for(int i=0;i<entries;i++)
+				if(data[palette+i*4]!=i || data[palette+i*4+1]!=i || data[palette+i*4+2]!=i)
+					return false;
+		}
 
-    //std::cout << "fileSize: " << fileSize << std::endl;
-    //std::cout << "dataOffset: " << dataOffset << std::endl;
-    //std::cout << "width: " << width << std::endl;
-    //std::cout << "height: " << height << std::endl;
-    //std::cout << "depth: " << depth << "-bit" << std::endl;
-    //std::cout << "channels: " << (int)image.channels << std::endl;
-    //std::vector<char> img(dataOffset - HEADER_SIZE);
-    //bmp.read(img.data(), img.size());
+		// Rows are padded to 4 bytes
+		uint8_t channels = depth/8;
+		size_t rowSize = (size_t(width)*depth/8 + 3) & ~size_t(3);
+		uint32_t rows = height<0 ? -int64_t(height) : height;
+		if(dataOffset>size || rowSize*rows>size-dataOffset || rowSize>INT32_MAX)
+			return false;
 
-    auto dataSize = ((width * 3 + 3) & (~3)) * height;
-    std::vector<char> img(dataSize);
-    img.resize(dataSize);
-    bmp.read(img.data(), img.size());
-    std::vector<unsigned char> buffer(dataSize);
+		const unsigned char* first = data+dataOffset;
+		if(height>0)// Bottom-up
+			pixels = ConstImageView(first+rowSize*(rows-1), width, rows, -int(rowSize), channels);
+		else
+			pixels = ConstImageView(first, width, rows, int(rowSize), channels);
+		return true;
+	}
 
-	for(int y=0;y<height;y++)
-		for(int x=0;x<width*3;x++)
-			buffer[(height-y-1)*width*3+x] = (unsigned char)(img[y*width*3+x]);//float(i)/dataSize*255;//
+	const unsigned char* data = nullptr;
+	size_t size = 0;
+	ConstImageView pixels;
+#if defined(_WIN32)
+	std::vector<unsigned char> fileData;
+#endif
+};
 
-	image.buffer = buffer;
+// Owning copy of a BMP file (top-down rows)
+Image readBmpFile(std::string path)
+{
+	Image image;
+	BmpFile bmp;
+	if(!bmp.open(path))
+		return image;
 
+	ConstImageView view = bmp.view();
+	image = createImage(view.width, view.height, view.channels);
+	size_t rowSize = view.width*view.channels;
+	for(int y=0;y<(int)view.height;y++)
+		std::copy(view.row(y), view.row(y)+rowSize, &image.buffer[y*rowSize]);
 	return image;
 }
 
+Image readBmp(std::string fileName)
+{
+	return readBmpFile(std::string("../../gallery/")+fileName+std::string(".bmp"));
+}
+
 #endif// HELPERS_H
@@ -0,0 +1,86 @@
+//--------------------------------------------------
+// Robot Simulator
+// homography.hpp
+// Date: 17/10/2026
+// By Breno Cunha Queiroz
+//--------------------------------------------------
+#ifndef HOMOGRAPHY_H
+#define HOMOGRAPHY_H
+#include <cmath>
+#include <algorithm>
+#include "helpers.hpp"
+
+// Row major 3x3, H[8] is normalized to 1
+struct Homography
+{
+	double h[9] = {1, 0, 0, 0, 1, 0, 0, 0, 1};
+
+	Point apply(double x, double y) const
+	{
+		double w = h[6]*x + h[7]*y + h[8];
+		return {float((h[0]*x + h[1]*y + h[2])/w), float((h[3]*x + h[4]*y + h[5])/w)};
+	}
+};
+
+// Solve the n x n system A x = b in place (partial pivoting), false if singular
+template<int N>
+bool solveLinear(double A[N][N], double b[N], double x[N])
+{
+	for(int col=0;col<N;col++)
+	{
+		int pivot = col;
+		for(int row=col+1;row<N;row++)
+			if(std::abs(A[row][col])>std::abs(A[pivot][col]))
+				pivot = row;
+		if(std::abs(A[pivot][col])<1e-12)
+			return false;
+		if(pivot!=col)
+		{
+			for(int k=0;k<N;k++)
+				std::swap(A[col][k], A[pivot][k]);
+			std::swap(b[col], b[pivot]);
+		}
+		for(int row=col+1;row<N;row++)
+		{
+			double factor = A[row][col]/A[col][col];
+			for(int k=col;k<N;k++)
+				A[row][k] -= factor*A[col][k];
+			b[row] -= factor*b[col];
+		}
+	}
+	for(int row=N-1;row>=0;row--)
+	{
+		double sum = b[row];
+		for(int k=row+1;k<N;k++)
+			sum -= A[row][k]*x[k];
+		x[row] = sum/A[row][row];
+	}
+	return true;
+}
+
+// Closed form 4 point DLT: H maps src[i] to dst[i]. No allocation.
+bool computeHomography(const Point src[4], const Point dst[4], Homography& homography)
+{
+	double A[8][8];
+	double b[8];
+	for(int i=0;i<4;i++)
+	{
+		double x = src[i].x, y = src[i].y;
+		double u = dst[i].x, v = dst[i].y;
+		double rowU[8] = {x, y, 1, 0, 0, 0, -u*x, -u*y};
+		double rowV[8] = {0, 0, 0, x, y, 1, -v*x, -v*y};
+		std::copy(rowU, rowU+8, A[2*i]);
+		std::copy(rowV, rowV+8, A[2*i+1]);
+		b[2*i] = u;
+		b[2*i+1] = v;
+	}
+
+	double h[8];
+	if(!solveLinear<8>(A, b, h))
+		return false;
+	std::copy(h, h+8, homography.h);
+	homography.h[8] = 1;
+	return true;
+}
+
+#endif// HOMOGRAPHY_H
@@ -9,327 +9,616 @@
 #include <vector>
 #include <iostream>
 #include <math.h>
+#include <algorithm>
 #include "helpers.hpp"
-
-Image derivate(Image image)
+#include "threadPool.hpp"
+#include "blur.hpp"
+#include "integral.hpp"
+#include "gradient.hpp"
+#include "labeling.hpp"
+#include "lineGraph.hpp"
+#include "quadFilter.hpp"
+#include "profiler.hpp"
+#include "arena.hpp"
+
+//--------------------//
+//---- Derivative ----//
+//--------------------//
+// Every operation has a view version writing into a caller provided destination
+// (which can be a strided sub rectangle) and an Image version wrapping it.
+void derivate(ConstImageView image, ImageView result)
 {
+	if(!sameSize(image, result) || image.channels!=result.channels)
+	{
+		std::cout << "[derivate] Incompatible images. Nothing done" << std::endl;
+		return;
+	}
+
 	for(int y=0;y<image.height;y++)
 	{
+		const unsigned char* src = image.row(y);
+		unsigned char* dst = result.row(y);
 		for(int x=1;x<image.width;x++)
 		{
 			for(int c=0;c<image.channels;c++)
 			{
-				int prev = image.buffer[y*image.width*image.channels + (x-1)*image.channels +c];
-				int now = image.buffer[y*image.width*image.channels + x*image.channels +c];
-				image.buffer[y*image.width*image.channels + (x-1)*image.channels +c] = ((now-prev)+255)/2;
+				int prev = src[(x-1)*image.channels +c];
+				int now = src[x*image.channels +c];
+				dst[(x-1)*image.channels +c] = ((now-prev)+255)/2;
 			}
 			if(x==image.width-1)
 				for(int c=0;c<image.channels;c++)
-					image.buffer[y*image.width*image.channels + x*image.channels+c] = 0;
+					dst[x*image.channels+c] = 0;
 		}
 	}
-	return image;
 }
 
-Image derivateAbs(Image image, bool horizontal=true)
+Image derivate(const Image& image)
+{
+	Image result = image;
+	derivate(image.view(), result.view());
+	return result;
+}
+
+// Horizontal: the last column is set to zero, vertical: the last row is set to zero
+void derivateAbs(ConstImageView image, ImageView result, bool horizontal=true, int numThreads=1)
 {
-	for(int y=horizontal?0:1;y<image.height;y++)
+	if(!sameSize(image, result) || image.channels!=result.channels)
 	{
-		for(int x=horizontal?1:0;x<image.width;x++)
+		std::cout << "[derivateAbs] Incompatible images. Nothing done" << std::endl;
+		return;
+	}
+
+	// Bands would read rows already overwritten by their neighbor
+	if(!horizontal && image.data==result.data)
+		numThreads = 1;
+
+	int rowSize = image.width*image.channels;
+	parallelRows(image.height, numThreads, [&](int y0, int y1)
+	{
+		for(int y=y0;y<y1;y++)
 		{
-			for(int c=0;c<image.channels;c++)
+			const unsigned char* src = image.row(y);
+			unsigned char* dst = result.row(y);
+			if(horizontal)
 			{
-				int prevIndex = horizontal?	(y*image.width*image.channels     + (x-1)*image.channels +c):
-										((y-1)*image.width*image.channels + x*image.channels +c);
-				int prev = image.buffer[prevIndex];
-				int now = image.buffer[y*image.width*image.channels + x*image.channels +c];
-				image.buffer[prevIndex] = std::abs(now-prev);
+				for(int i=0;i+image.channels<rowSize;i++)
+					dst[i] = std::abs(src[i+image.channels]-src[i]);
+				for(int i=std::max(0, rowSize-image.channels);i<rowSize;i++)
+					dst[i] = 0;
 			}
-			if(x==image.width-1)
-				for(int c=0;c<image.channels;c++)
-					image.buffer[y*image.width*image.channels + x*image.channels+c] = 0;
+			else if(y+1<image.height)
+			{
+				const unsigned char* next = image.row(y+1);
+				for(int i=0;i<rowSize;i++)
+					dst[i] = std::abs(next[i]-src[i]);
+			}
+			else
+				std::fill(dst, dst+rowSize, 0);
 		}
-	}
-	return image;
+	});
 }
 
-Image computeEdgels(Image image, int thresh)
+Image derivateAbs(const Image& image, bool horizontal=true, int numThreads=1)
 {
-	Image result;
-	result.width = image.width;
-	result.height = image.height;
-	result.channels = 1;
-	result.buffer = std::vector<unsigned char>(result.width*result.height);
+	Image result = image;
+	derivateAbs(image.view(), result.view(), horizontal, numThreads);
+	return result;
+}
+
+//--------------------//
+//------ Edgels ------//
+//--------------------//
+void computeEdgels(ConstImageView image, ImageView result, int thresh, int numThreads=1)
+{
+	if(!sameSize(image, result) || image.channels!=1 || result.channels!=1)
+	{
+		std::cout << "[computeEdgels] Incompatible images. Nothing done" << std::endl;
+		return;
+	}
 
 	// θ = arctan(gy/gx)
 	// gy: y-component of the gradient
 	// gx: x-component of the gradient
-	for(int y=1;y<image.height;y++)
+	parallelRows(image.height, numThreads, [&](int y0, int y1)
 	{
-		for(int x=1;x<image.width;x++)
+		std::vector<int16_t> dx(image.width);
+		std::vector<int16_t> dy(image.width);
+		for(int y=y0;y<y1;y++)
 		{
-			int prevX = image.buffer[y*image.width + (x-1)];
-			int prevY = image.buffer[(y-1)*image.width + x];
-			int now = image.buffer[y*image.width + x];
-			int dx = now-prevX;
-			int dy = now-prevY;
-			if(dx>thresh || dy>thresh || dx<-thresh || dy<-thresh)
-			{
-				// TODO Use a lookup table (faster)
-				result.buffer[y*result.width + x] = std::atan2(dy, dx)*255./(M_PI*2);
-			}
+			unsigned char* dst = result.row(y);
+			std::fill(dst, dst+result.width, 0);
+			if(y==0)
+				continue;
+			gradientRow(image.row(y), image.row(y-1), image.width, dx.data(), dy.data());
+			edgelRow(dx.data(), dy.data(), image.width, thresh, dst);
 		}
-	}
+	});
+}
+
+Image computeEdgels(const Image& image, int thresh, int numThreads=1)
+{
+	Image result = createImage(image.width, image.height, 1);
+	computeEdgels(image.view(), result.view(), thresh, numThreads);
 	return result;
 }
 
-Image convolution(Image image, std::vector<float> kernel)
+//--------------------//
+//---- Convolution ---//
+//--------------------//
+// Rows [yr0,yr1) of a non separable convolution. RADIUS and CHANNELS are 0
+// when only known at run time, constants unroll the kernel loops.
+template<int RADIUS=0, int CHANNELS=0>
+void convolutionRows(ConstImageView image, ImageView result, const float* kernel, int kernelSize, int yr0, int yr1)
 {
-	int kernelSize = (sqrt(kernel.size())/2);// Kernel half side lenght
+	// A local copy can not alias the destination, so constant kernels stay in registers
+	float weights[RADIUS>0 ? (2*RADIUS+1)*(2*RADIUS+1) : 1];
+	if(RADIUS>0)
+	{
+		std::copy(kernel, kernel+(2*RADIUS+1)*(2*RADIUS+1), weights);
+		kernel = weights;
+		kernelSize = RADIUS;
+	}
+	int channels = CHANNELS>0 ? CHANNELS : image.channels;
+	int side = kernelSize*2+1;
 
-	Image result;
-	result.width = image.width-kernelSize*2;
-	result.height = image.height-kernelSize*2;
-	result.channels = image.channels;
-	result.buffer = std::vector<unsigned char>(result.width*result.height*result.channels);
-	
-	for(int y=kernelSize, yr=0; y<image.height-kernelSize; y++, yr++)
+	// Element i of an output row is channel c of pixel xr (i = xr*channels+c),
+	// its taps in the input rows are i+kx*channels: no loop over the channels
+	int rowSize = result.width*channels;
+	for(int yr=yr0; yr<yr1; yr++)
 	{
-		for(int x=kernelSize, xr=0; x<image.width-kernelSize; x++, xr++)
+		unsigned char* dst = result.row(yr);
+		for(int i=0;i<rowSize;i++)
 		{
-			for(int c=0;c<image.channels;c++)
+			float sum=0;
+			for(int ky=0;ky<side;ky++)
 			{
-				float sum=0;
-				for(int ky=-kernelSize;ky<kernelSize;ky++)
-					for(int kx=-kernelSize;kx<kernelSize;kx++)
-					{
-						sum += kernel[(ky+kernelSize)*(kernelSize*2+1) + (kx+kernelSize)] 
-							* image.buffer[(y+ky)*image.width*image.channels + (x+kx)*image.channels + c];
-					}
-
-				result.buffer[yr*result.width*image.channels + xr*image.channels + c] = (unsigned char)sum;
+				const unsigned char* src = image.row(yr+ky) + i;
+				for(int kx=0;kx<side;kx++)
+					sum += kernel[ky*side + kx]*src[kx*channels];
 			}
+			dst[i] = (unsigned char)sum;
 		}
 	}
+}
+
+typedef void (*ConvolutionRows)(ConstImageView, ImageView, const float*, int, int, int);
+
+template<int CHANNELS>
+ConvolutionRows convolutionRowsFor(int kernelSize)
+{
+	switch(kernelSize)
+	{
+		case 1: return convolutionRows<1, CHANNELS>;
+		case 2: return convolutionRows<2, CHANNELS>;
+		case 3: return convolutionRows<3, CHANNELS>;
+		default: return convolutionRows<0, CHANNELS>;
+	}
+}
+
+// Specialized rows for 3x3, 5x5 and 7x7 kernels on 1 or 3 channels
+ConvolutionRows convolutionRowsFor(int kernelSize, int channels)
+{
+	if(channels==1)
+		return convolutionRowsFor<1>(kernelSize);
+	if(channels==3)
+		return convolutionRowsFor<3>(kernelSize);
+	return convolutionRows<0, 0>;
+}
+
+// The result is smaller than the image by the kernel radius on each side
+void convolution(ConstImageView image, ImageView result, const std::vector<float>& kernel, int numThreads=1)
+{
+	// Separable kernels run through the fixed point blur engine
+	std::vector<float> column, row;
+	SeparableKernel separable;
+	if(factorizeKernel(kernel, column, row) && makeSeparableKernel(column, row, separable))
+	{
+		FrameArena arena;
+		separableConvolution(image, result, separable, arena, true, numThreads);
+		return;
+	}
+
+	int kernelSize = (sqrt(kernel.size())/2);// Kernel half side lenght
+	if((int)image.width<=kernelSize*2 || (int)image.height<=kernelSize*2 ||
+		result.width!=image.width-kernelSize*2 || result.height!=image.height-kernelSize*2 || result.channels!=image.channels)
+	{
+		std::cout << "[convolution] Incompatible images. Nothing done" << std::endl;
+		return;
+	}
+
+	// Each band reads kernelSize rows above and below it (halo)
+	ConvolutionRows rows = convolutionRowsFor(kernelSize, image.channels);
+	parallelRows(result.height, numThreads, [&](int y0, int y1)
+	{
+		rows(image, result, kernel.data(), kernelSize, y0, y1);
+	});
+}
 
+Image convolution(const Image& image, const std::vector<float>& kernel, int numThreads=1)
+{
+	int kernelSize = (sqrt(kernel.size())/2);
+	if((int)image.width<=kernelSize*2 || (int)image.height<=kernelSize*2)
+		return Image();
+
+	Image result = createImage(image.width-kernelSize*2, image.height-kernelSize*2, image.channels);
+	convolution(image.view(), result.view(), kernel, numThreads);
 	return result;
 }
 
-Image grayscale(Image image)
+//--------------------//
+//----- Grayscale ----//
+//--------------------//
+void grayscale(ConstImageView image, ImageView result)
 {
-	Image result;
-	result.width = image.width;
-	result.height = image.height;
-	result.channels = 1;
-	result.buffer = std::vector<unsigned char>(result.width*result.height);
+	if(!sameSize(image, result) || result.channels!=1)
+	{
+		std::cout << "[grayscale] Incompatible images. Nothing done" << std::endl;
+		return;
+	}
 
 	for(int y=0;y<image.height;y++)
 	{
+		const unsigned char* src = image.row(y);
+		unsigned char* dst = result.row(y);
 		for(int x=0;x<image.width;x++)
 		{
 			int mean=0;
 			for(int c=0;c<image.channels;c++)
-				mean += image.buffer[y*image.width*image.channels + x*image.channels + c];
+				mean += src[x*image.channels + c];
 			mean/=image.channels;
 
-			result.buffer[y*image.width + x] = mean;
+			dst[x] = mean;
 		}
 	}
+}
+
+Image grayscale(const Image& image)
+{
+	Image result = createImage(image.width, image.height, 1);
+	grayscale(image.view(), result.view());
 	return result;
 }
 
-Image grayscaleToColor(Image image)
+void grayscaleToColor(ConstImageView image, ImageView result, int numThreads=1)
 {
 	// TODO
 	if(image.channels!=1)
 	{
 		std::cout << "[grayscaleToColor] Image should be in gray scale" << std::endl;
-		return image;
+		return;
+	}
+	if(!sameSize(image, result) || result.channels!=3)
+	{
+		std::cout << "[grayscaleToColor] Incompatible images. Nothing done" << std::endl;
+		return;
 	}
 
-	Image result;
-	result.width = image.width;
-	result.height = image.height;
-	result.channels = 3;
-	result.buffer = std::vector<unsigned char>(result.width*result.height*result.channels);
-
-	for(int y=0;y<image.height;y++)
+	parallelRows(image.height, numThreads, [&](int y0, int y1)
 	{
-		for(int x=0;x<image.width;x++)
+		for(int y=y0;y<y1;y++)
 		{
-			unsigned char val = image.buffer[y*image.width + x];
-			if(val==0)
-				continue;
-
-			if(val<255/4)
-				result.buffer[y*result.width*result.channels + x*result.channels] = 255;
-			else if(val<255/2)
-				result.buffer[y*result.width*result.channels + x*result.channels+1] = 255;
-			else if(val<3*255/4)
-				result.buffer[y*result.width*result.channels + x*result.channels+2] = 255;
-			else
+			const unsigned char* src = image.row(y);
+			unsigned char* dst = result.row(y);
+			std::fill(dst, dst+result.width*result.channels, 0);
+			for(int x=0;x<image.width;x++)
 			{
-				result.buffer[y*result.width*result.channels + x*result.channels] = 255;
-				result.buffer[y*result.width*result.channels + x*result.channels+2] = 255;
+				unsigned char val = src[x];
+				if(val==0)
+					continue;
+
+				if(val<255/4)
+					dst[x*result.channels] = 255;
+				else if(val<255/2)
+					dst[x*result.channels+1] = 255;
+				else if(val<3*255/4)
+					dst[x*result.channels+2] = 255;
+				else
+				{
+					dst[x*result.channels] = 255;
+					dst[x*result.channels+2] = 255;
+				}
 			}
 		}
+	});
+}
+
+Image grayscaleToColor(const Image& image, int numThreads=1)
+{
+	if(image.channels!=1)
+	{
+		std::cout << "[grayscaleToColor] Image should be in gray scale" << std::endl;
+		return image;
 	}
+
+	Image result = createImage(image.width, image.height, 3);
+	grayscaleToColor(image.view(), result.view(), numThreads);
 	return result;
 }
 
-Image grayscaleMax(Image image)
+// Alpha (fourth channel) is not used
+void grayscaleMaxRow(const unsigned char* src, int width, int channels, unsigned char* dst)
 {
-	Image result;
-	result.width = image.width;
-	result.height = image.height;
-	result.channels = 1;
-	result.buffer = std::vector<unsigned char>(result.width*result.height);
+	if(channels==1)
+	{
+		std::copy(src, src+width, dst);
+		return;
+	}
 
-	for(int y=0;y<image.height;y++)
+	int colorChannels = std::min(channels, 3);
+	for(int x=0;x<width;x++)
 	{
-		for(int x=0;x<image.width;x++)
-		{
-			int maximum=0;
-			for(int c=0;c<image.channels;c++)
-				maximum = std::max(maximum,(int)image.buffer[y*image.width*image.channels + x*image.channels + c]);
+		int maximum=0;
+		for(int c=0;c<colorChannels;c++)
+			maximum = std::max(maximum,(int)src[x*channels + c]);
 
-			result.buffer[y*image.width + x] = maximum;
-		}
+		dst[x] = maximum;
+	}
+}
+
+void grayscaleMax(ConstImageView image, ImageView result, int numThreads=1)
+{
+	if(!sameSize(image, result) || result.channels!=1)
+	{
+		std::cout << "[grayscaleMax] Incompatible images. Nothing done" << std::endl;
+		return;
 	}
+
+	parallelRows(image.height, numThreads, [&](int y0, int y1)
+	{
+		for(int y=y0;y<y1;y++)
+			grayscaleMaxRow(image.row(y), image.width, image.channels, result.row(y));
+	});
+}
+
+Image grayscaleMax(const Image& image, int numThreads=1)
+{
+	Image result = createImage(image.width, image.height, 1);
+	grayscaleMax(image.view(), result.view(), numThreads);
 	return result;
 }
 
-Image grayscaleIgnoreColor(Image image)
+void grayscaleIgnoreColor(ConstImageView image, ImageView result)
 {
-	Image result;
-	result.width = image.width;
-	result.height = image.height;
-	result.channels = 1;
-	result.buffer = std::vector<unsigned char>(result.width*result.height);
+	if(!sameSize(image, result) || result.channels!=1)
+	{
+		std::cout << "[grayscaleIgnoreColor] Incompatible images. Nothing done" << std::endl;
+		return;
+	}
 
 	for(int y=0;y<image.height;y++)
 	{
+		const unsigned char* src = image.row(y);
+		unsigned char* dst = result.row(y);
 		for(int x=0;x<image.width;x++)
 		{
 			int maximum=0;
 			int minimum=255;
 			for(int c=0;c<image.channels;c++)
 			{
-				maximum = std::max(maximum,(int)image.buffer[y*image.width*image.channels + x*image.channels + c]);
-				minimum = std::min(minimum,(int)image.buffer[y*image.width*image.channels + x*image.channels + c]);
+				maximum = std::max(maximum,(int)src[x*image.channels + c]);
+				minimum = std::min(minimum,(int)src[x*image.channels + c]);
 			}
 			int diff = maximum-minimum;
 			if(diff<20)
-				result.buffer[y*image.width + x] = maximum;
+				dst[x] = maximum;
 			else
-				result.buffer[y*image.width + x] = 255;
+				dst[x] = 255;
 		}
 	}
+}
+
+Image grayscaleIgnoreColor(const Image& image)
+{
+	Image result = createImage(image.width, image.height, 1);
+	grayscaleIgnoreColor(image.view(), result.view());
 	return result;
 }
 
-Image threshold(Image image, unsigned char thresh)
+//--------------------//
+//------ Binary ------//
+//--------------------//
+// Can run in place (image and result pointing to the same pixels)
+void threshold(ConstImageView image, ImageView result, unsigned char thresh, int numThreads=1)
 {
-	for(int y=0;y<image.height;y++)
+	if(!sameSize(image, result) || image.channels!=result.channels)
 	{
-		for(int x=0;x<image.width;x++)
-		{
-			int mean=0;
-			for(int c=0;c<image.channels;c++)
-				mean += image.buffer[y*image.width*image.channels + x*image.channels + c];
-			mean/=image.channels;
+		std::cout << "[threshold] Incompatible images. Nothing done" << std::endl;
+		return;
+	}
 
-			if(mean>thresh)
+	parallelRows(image.height, numThreads, [&](int y0, int y1)
+	{
+		for(int y=y0;y<y1;y++)
+		{
+			const unsigned char* src = image.row(y);
+			unsigned char* dst = result.row(y);
+			for(int x=0;x<image.width;x++)
+			{
+				int mean=0;
 				for(int c=0;c<image.channels;c++)
-					image.buffer[y*image.width*image.channels + x*image.channels + c] = 255;
-			else
+					mean += src[x*image.channels + c];
+				mean/=image.channels;
+
+				unsigned char value = mean>thresh ? 255 : 0;
 				for(int c=0;c<image.channels;c++)
-					image.buffer[y*image.width*image.channels + x*image.channels + c] = 0;
+					dst[x*image.channels + c] = value;
+			}
 		}
+	});
+}
+
+Image threshold(const Image& image, unsigned char thresh, int numThreads=1)
+{
+	Image result = image;
+	threshold(image.view(), result.view(), thresh, numThreads);
+	return result;
+}
+
+// Local mean threshold, for lighting too uneven for a global one: a pixel is
+// white if it is brighter than the mean of its (2*radius+1)^2 window (clipped
+// at the borders) minus offset. Gray input only, the cost does not depend on
+// the radius. The integral image and the row buffers are allocated in the arena.
+void adaptiveThreshold(ConstImageView image, ImageView result, int radius, int offset, FrameArena& arena, int numThreads=1)
+{
+	if(!sameSize(image, result) || image.channels!=1 || result.channels!=1 || radius<0)
+	{
+		std::cout << "[adaptiveThreshold] Incompatible images. Nothing done" << std::endl;
+		return;
 	}
-	return image;
+
+	IntegralImage integral;
+	computeIntegralImage(image, integral, arena, numThreads);
+	parallelRows(image.height, numThreads, [&](int y0, int y1)
+	{
+		uint32_t* sums = arena.allocate<uint32_t>(image.width);
+		uint32_t* counts = arena.allocate<uint32_t>(image.width);
+		for(int y=y0;y<y1;y++)
+		{
+			windowSumsRow(integral, y, radius, sums, counts);
+			const unsigned char* src = image.row(y);
+			unsigned char* dst = result.row(y);
+			// value > sum/count - offset, without the division
+			for(int x=0;x<image.width;x++)
+				dst[x] = int64_t(src[x]+offset)*counts[x] > int64_t(sums[x]) ? 255 : 0;
+		}
+	});
 }
 
-Image mergeMax(Image image1, Image image2)
+Image adaptiveThreshold(const Image& image, int radius, int offset, int numThreads=1)
 {
-	if(image1.width!=image2.width || image1.height!=image2.height || image1.channels!=image2.channels)
+	FrameArena arena;
+	Image result = createImage(image.width, image.height, 1);
+	adaptiveThreshold(image.view(), result.view(), radius, offset, arena, numThreads);
+	return result;
+}
+
+//--------------------//
+//------ Merge -------//
+//--------------------//
+// Can run in place (result pointing to the pixels of image1 or image2)
+void mergeMax(ConstImageView image1, ConstImageView image2, ImageView result)
+{
+	if(!sameSize(image1, image2) || image1.channels!=image2.channels || !sameSize(image1, result) || image1.channels!=result.channels)
 	{
 		std::cout << "[mergeMax] Incompatible images. Nothing done" << std::endl;
-		return image1;
+		return;
 	}
 
+	int rowSize = image1.width*image1.channels;
 	for(int y=0;y<image1.height;y++)
 	{
-		for(int x=0;x<image1.width;x++)
-		{
-			for(int c=0;c<image1.channels;c++)
-			{
-				int index = y*image1.width*image1.channels + x*image1.channels + c;
-				image1.buffer[index]=std::max(image1.buffer[index], image2.buffer[index]);
-			}
-		}
+		const unsigned char* src1 = image1.row(y);
+		const unsigned char* src2 = image2.row(y);
+		unsigned char* dst = result.row(y);
+		for(int i=0;i<rowSize;i++)
+			dst[i] = std::max(src1[i], src2[i]);
+	}
+}
+
+Image mergeMax(const Image& image1, const Image& image2)
+{
+	if(image1.width!=image2.width || image1.height!=image2.height || image1.channels!=image2.channels)
+	{
+		std::cout << "[mergeMax] Incompatible images. Nothing done" << std::endl;
+		return image1;
 	}
-	return image1;
+
+	Image result = createImage(image1.width, image1.height, image1.channels);
+	mergeMax(image1.view(), image2.view(), result.view());
+	return result;
 }
 
-Image mergeRGB(Image imageR, Image imageG, Image imageB)
+void mergeRGB(ConstImageView imageR, ConstImageView imageG, ConstImageView imageB, ImageView result)
 {
-	// TODO error handling
-	Image result;
-	result.width = imageR.width;
-	result.height = imageR.height;
-	result.channels = 3;
-	result.buffer = std::vector<unsigned char>(result.width*result.height*result.channels);
+	if(!sameSize(imageR, imageG) || !sameSize(imageR, imageB) || !sameSize(imageR, result) || result.channels!=3)
+	{
+		std::cout << "[mergeRGB] Incompatible images. Nothing done" << std::endl;
+		return;
+	}
 
 	for(int y=0;y<result.height;y++)
 	{
+		const unsigned char* r = imageR.row(y);
+		const unsigned char* g = imageG.row(y);
+		const unsigned char* b = imageB.row(y);
+		unsigned char* dst = result.row(y);
 		for(int x=0;x<result.width;x++)
 		{
-			int index = y*result.width*result.channels + x*result.channels;
-			result.buffer[index+0] = imageR.buffer[y*result.width+x];
-			result.buffer[index+1] = imageG.buffer[y*result.width+x];
-			result.buffer[index+2] = imageB.buffer[y*result.width+x];
+			dst[x*result.channels+0] = r[x*imageR.channels];
+			dst[x*result.channels+1] = g[x*imageG.channels];
+			dst[x*result.channels+2] = b[x*imageB.channels];
 		}
 	}
+}
+
+Image mergeRGB(const Image& imageR, const Image& imageG, const Image& imageB)
+{
+	Image result = createImage(imageR.width, imageR.height, 3);
+	mergeRGB(imageR.view(), imageG.view(), imageB.view(), result.view());
 	return result;
 }
 
-Image mergeOrientation(Image image1, Image image2)
+// The first channel of result is the orientation where image1/image2 (dx/dy) are
+// strong enough, everything else is copied from image1
+void mergeOrientation(ConstImageView image1, ConstImageView image2, ImageView result)
 {
 	// TODO
-	if(image1.width!=image2.width || image1.height!=image2.height || image1.channels!=image2.channels)
+	if(!sameSize(image1, image2) || image1.channels!=image2.channels || !sameSize(image1, result) || image1.channels!=result.channels)
 	{
 		std::cout << "[mergeOrientation] Incompatible images. Nothing done" << std::endl;
-		return image1;
+		return;
 	}
 
 	for(int y=0;y<image1.height;y++)
 	{
+		const unsigned char* src1 = image1.row(y);
+		const unsigned char* src2 = image2.row(y);
+		unsigned char* dst = result.row(y);
 		for(int x=0;x<image1.width;x++)
 		{
-			int index = y*image1.width*image1.channels + x*image1.channels;
-			float dx = image1.buffer[index];
-			float dy = image2.buffer[index];
+			int index = x*image1.channels;
+			for(int c=0;c<image1.channels;c++)
+				dst[index+c] = src1[index+c];
+
+			float dx = src1[index];
+			float dy = src2[index];
 			if(dx>10 || dy>10)
-				image1.buffer[index]=atan2(dy,dx)/(2*M_PI)*255.f;
+				dst[index]=atan2(dy,dx)/(2*M_PI)*255.f;
 		}
 	}
-	return image1;
 }
 
-Image zhangSuen(Image image)
+Image mergeOrientation(const Image& image1, const Image& image2)
+{
+	if(image1.width!=image2.width || image1.height!=image2.height || image1.channels!=image2.channels)
+	{
+		std::cout << "[mergeOrientation] Incompatible images. Nothing done" << std::endl;
+		return image1;
+	}
+
+	Image result = createImage(image1.width, image1.height, image1.channels);
+	mergeOrientation(image1.view(), image2.view(), result.view());
+	return result;
+}
+
+//--------------------//
+//----- Thinning -----//
+//--------------------//
+// In place
+void zhangSuen(ImageView image)
 {
 	// Reference https://rosettacode.org/wiki/Zhang-Suen_thinning_algorithm
 	if(image.channels != 1)
 	{
 		std::cout << "[zhangSuen] Image should have only one channels. Nothing done." << std::endl;
-		return image;
+		return;
 	}
 
-	int width = image.width;
-	std::vector<int> sequence = {-width, -width+1, +1, width+1, width, width-1, -1, -width-1, -width};
+	int stride = image.stride;
+	std::vector<int> sequence = {-stride, -stride+1, +1, stride+1, stride, stride-1, -1, -stride-1, -stride};
 
-	std::vector<int> pixelsToRemove;
+	std::vector<unsigned char*> pixelsToRemove;
 	bool repeat;
 	do{
 		repeat = false;
@@ -337,197 +626,166 @@ Image zhangSuen(Image image)
 		for(int step = 1; step<=2;step++)
 		{
 			pixelsToRemove.clear();
-			for(int y=1;y<image.height-1;y++)
+			for(int y=1;y<(int)image.height-1;y++)
 			{
-				for(int x=1;x<image.width-1;x++)
+				for(int x=1;x<(int)image.width-1;x++)
 				{
-					int index = y*image.width + x;
-					if(image.buffer[index]!=255)// Only check white pixels
+					unsigned char* pixel = &image.at(x, y);
+					if(*pixel!=255)// Only check white pixels
 						continue;
 
 					// Calculate B
 					int B=0;
 					for(auto offset : sequence)
-						if(image.buffer[index+offset] == 0)
+						if(pixel[offset] == 0)
 							B++;
 
 					// Calculate A
 					int A=0;
-					unsigned char lastVal = image.buffer[index+sequence[0]];
+					unsigned char lastVal = pixel[sequence[0]];
 					for(auto offset : sequence)
-						if(image.buffer[index+offset] == 0 && lastVal == 255)
+						if(pixel[offset] == 0 && lastVal == 255)
 						{
 							A++;
-							lastVal = image.buffer[index+offset];
+							lastVal = pixel[offset];
 						}
 
 					// Check if should set as black
 					if(B>=2 && B<=6 && A==1 &&
-							(image.buffer[index+sequence[0]]==255 || image.buffer[index+sequence[2]]==255 || image.buffer[index+sequence[(step==1?4:6)]]==255) &&
-							(image.buffer[index+sequence[(step==1?2:0)]]==255 || image.buffer[index+sequence[4]]==255 || image.buffer[index+sequence[6]]==255))
+							(pixel[sequence[0]]==255 || pixel[sequence[2]]==255 || pixel[sequence[(step==1?4:6)]]==255) &&
+							(pixel[sequence[(step==1?2:0)]]==255 || pixel[sequence[4]]==255 || pixel[sequence[6]]==255))
 					{
-						pixelsToRemove.push_back(index);
+						pixelsToRemove.push_back(pixel);
 						repeat = true;
 					}
 
 				}
 			}
 			// Set pixels as black
-			for(auto index : pixelsToRemove)
+			for(auto pixel : pixelsToRemove)
 			{
-				image.buffer[index] = 0;
+				*pixel = 0;
 			}
 		}
 	}while(repeat);
-
-	return image;
 }
 
-std::vector<bool> visited;
-Image imageToCompute;
-
-std::vector<Point> getRegion(Point point, unsigned char value)
+Image zhangSuen(const Image& image)
 {
-	if(point.x<0 || point.y<0 || point.x>=imageToCompute.width || point.y>=imageToCompute.height)
-		return {};
-
-	unsigned char currVal = imageToCompute.buffer[point.y*imageToCompute.width + point.x];
-	int error = std::abs(currVal-value);
-	if(error>127)
-		error = 255-error;
-	if(currVal==0 || error > 25 || visited[point.y*imageToCompute.width+point.x])
-		return {};
-
-	// 4 or 8 neighbors?
-	visited[point.y*imageToCompute.width+point.x] = true;
-	std::vector<Point> reg1 = getRegion({point.x+1, point.y}, value);
-	std::vector<Point> reg2 = getRegion({point.x-1, point.y}, value);
-	std::vector<Point> reg3 = getRegion({point.x, point.y+1}, value);
-	std::vector<Point> reg4 = getRegion({point.x, point.y-1}, value);
-
-	std::vector<Point> result = {point};
-	result.insert(result.end(), reg1.begin(), reg1.end());
-	result.insert(result.end(), reg2.begin(), reg2.end());
-	result.insert(result.end(), reg3.begin(), reg3.end());
-	result.insert(result.end(), reg4.begin(), reg4.end());
-
+	Image result = image;
+	zhangSuen(result.view());
 	return result;
 }
 
-std::vector<Line> computeLines(Image image)
+//--------------------//
+//------- Lines ------//
+//--------------------//
+// Lines are written to the caller's vector (keeping its capacity), the
+// components only live in the arena
+void computeLines(ConstImageView image, std::vector<Line>& lines, FrameArena& arena)
 {
-	visited = std::vector<bool>(image.width*image.height);
-	imageToCompute = image;
+	lines.clear();
 
-	std::cout << "Width " << imageToCompute.width << " height" << imageToCompute.height << std::endl;
-	std::vector<Line> lines;
+	ArenaVector<ComponentMoments> components(arena);
+	labelComponents(image, 25, components, arena);
+	PROFILE_COUNT(PROFILE_REGIONS, components.size());
 
-	for(int y=0;y<imageToCompute.height;y++)
+	for(const auto& region : components)
 	{
-		for(int x=0;x<imageToCompute.width;x++)
+		PROFILE_COUNT(PROFILE_EDGELS, region.count);// Every edgel is in a region
+		// Ignore small regions
+		if(region.count<20)
 		{
-			if(!visited[y*imageToCompute.width+x])
-			{
-				unsigned char value = imageToCompute.getPixel(x,y);
-				if(value>0)
-				{
-					//std::cout << "Calculate region" << std::endl;
-					std::vector<Point> region = getRegion({x,y}, value);
-
-					// Ignore small regions
-					if((int)region.size()<20)
-						continue;
-
-					// Calculate principal axis
-					float w = 1.f;
-					float sumW = w*region.size();
-					float sumXsquare = 0;
-					float sumX = 0;
-					float sumYsquare = 0;
-					float sumY = 0;
-					float sumXY = 0;
-
-					int maxX = 0;
-					int maxY = 0;
-					int minX = 999999;
-					int minY = 999999;
-
-					for(auto point : region)
-					{
-						sumXsquare += w*point.x*point.x;
-						sumX += w*point.x;
-						sumYsquare += w*point.y*point.y;
-						sumY += w*point.y;
-						sumXY += w*point.x*point.y;
-						maxX = std::max(float(maxX), point.x);
-						maxY = std::max(float(maxY), point.y);
-						minX = std::min(float(minX), point.x);
-						minY = std::min(float(minY), point.y);
-					}
-
-					// Compute center
-					Point center = {sumX/sumW, sumY/sumW};
-
-					// Compute eigen values
-					float a = sumXsquare-sumX*sumX/sumW;
-					float b = sumXY-sumX*sumY/sumW;
-					float c = sumYsquare-sumY*sumY/sumW;
-
-					float delta = sqrt((a-c)*(a-c)/4+b*b);
-					float Vs = (a+c)/2-delta;// Small eigen value
-					float Vl = (a+c)/2+delta;// Large eigen value
-
-					// Compute line angle
-					float lineAngle = atan2((Vl-a),b);
-
-					// Straightness of the line (small is better)
-					float straightness = sqrt(Vs)/sqrt(Vl);
-
-					// Wrong orientation if not using lineAngle
-					bool tiltedRight = (lineAngle<M_PI/2 && lineAngle>0) || (lineAngle<-M_PI/2);
-					//Point extreme0 = {minX, tiltedRight ? minY : maxY};
-					//Point extreme1 = {maxX, !tiltedRight ? minY : maxY};
-					Point extreme0;
-					Point extreme1;
-					if(tiltedRight)
-					{
-						// Compute segment size (Approximation)
-						float dx = maxX-center.x;
-						float dy = maxY-center.y;
-						float sizeUp = sqrt(dx*dx + dy*dy);
-						dx = center.x-minX;
-						dy = center.y-minY;
-						float sizeDown = sqrt(dx*dx + dy*dy);
-
-						extreme0 = {center.x+cos(lineAngle)*sizeUp, center.y+sin(lineAngle)*sizeUp};
-						extreme1 = {center.x+cos(M_PI+lineAngle)*sizeDown, center.y+sin(M_PI+lineAngle)*sizeDown};
-					}
-					else
-					{
-						// Compute segment size (Approximation)
-						float dx = center.x-minX;
-						float dy = maxY-center.y;
-						float sizeUp = sqrt(dx*dx + dy*dy);
-						dx = maxX-center.x;
-						dy = center.y-minY;
-						float sizeDown = sqrt(dx*dx + dy*dy);
-
-						extreme0 = {center.x+cos(lineAngle)*sizeUp, center.y+sin(lineAngle)*sizeUp};
-						extreme1 = {center.x+cos(M_PI+lineAngle)*sizeDown, center.y+sin(M_PI+lineAngle)*sizeDown};
-					}
+			PROFILE_COUNT(PROFILE_SMALL_REGIONS, 1);
+			continue;
+		}
 
-					// Add line
-					lines.push_back({extreme0,extreme1});
-				}
-			}
+		// Principal axis from the region moments (double avoids cancellation in the central moments)
+		double sumW = region.count;
+		double sumXsquare = region.sumXsquare;
+		double sumX = region.sumX;
+		double sumYsquare = region.sumYsquare;
+		double sumY = region.sumY;
+		double sumXY = region.sumXY;
+
+		float maxX = region.maxX;
+		float maxY = region.maxY;
+		float minX = region.minX;
+		float minY = region.minY;
+
+		// Compute center
+		Point center = {float(sumX/sumW), float(sumY/sumW)};
+
+		// Compute eigen values
+		float a = sumXsquare-sumX*sumX/sumW;
+		float b = sumXY-sumX*sumY/sumW;
+		float c = sumYsquare-sumY*sumY/sumW;
+
+		float delta = sqrt((a-c)*(a-c)/4+b*b);
+		float Vs = (a+c)/2-delta;// Small eigen value
+		float Vl = (a+c)/2+delta;// Large eigen value
+
+		// Compute line angle
+		float lineAngle = atan2((Vl-a),b);
+
+		// Straightness of the line (small is better)
+		float straightness = sqrt(Vs)/sqrt(Vl);
+
+		// Wrong orientation if not using lineAngle
+		bool tiltedRight = (lineAngle<M_PI/2 && lineAngle>0) || (lineAngle<-M_PI/2);
+		//Point extreme0 = {minX, tiltedRight ? minY : maxY};
+		//Point extreme1 = {maxX, !tiltedRight ? minY : maxY};
+		Point extreme0;
+		Point extreme1;
+		if(tiltedRight)
+		{
+			// Compute segment size (Approximation)
+			float dx = maxX-center.x;
+			float dy = maxY-center.y;
+			float sizeUp = sqrt(dx*dx + dy*dy);
+			dx = center.x-minX;
+			dy = center.y-minY;
+			float sizeDown = sqrt(dx*dx + dy*dy);
+
+			extreme0 = {center.x+cos(lineAngle)*sizeUp, center.y+sin(lineAngle)*sizeUp};
+			extreme1 = {center.x+cos(M_PI+lineAngle)*sizeDown, center.y+sin(M_PI+lineAngle)*sizeDown};
+		}
+		else
+		{
+			// Compute segment size (Approximation)
+			float dx = center.x-minX;
+			float dy = maxY-center.y;
+			float sizeUp = sqrt(dx*dx + dy*dy);
+			dx = maxX-center.x;
+			dy = center.y-minY;
+			float sizeDown = sqrt(dx*dx + dy*dy);
+
+			extreme0 = {center.x+cos(lineAngle)*sizeUp, center.y+sin(lineAngle)*sizeUp};
+			extreme1 = {center.x+cos(M_PI+lineAngle)*sizeDown, center.y+sin(M_PI+lineAngle)*sizeDown};
 		}
-	}
 
-	visited.clear();
+		// Add line
+		lines.push_back({extreme0,extreme1});
+	}
+	PROFILE_COUNT(PROFILE_LINES, lines.size());
+}
 
+std::vector<Line> computeLines(ConstImageView image)
+{
+	FrameArena arena;
+	std::vector<Line> lines;
+	computeLines(image, lines, arena);
 	return lines;
 }
 
+std::vector<Line> computeLines(const Image& image)
+{
+	return computeLines(image.view());
+}
+
+//--------------------//
+//--- Quadrangles ----//
+//--------------------//
 float minLineDistance(Line l0, Line l1)
 {
 	float dx[4] = {l1.p0.x-l0.p0.x, l1.p1.x-l0.p0.x, l1.p0.x-l0.p1.x, l1.p1.x-l0.p1.x};
@@ -541,13 +799,14 @@ float minLineDistance(Line l0, Line l1)
 	return minDist;
 }
 
-Quadrangle getQuadFromLines(std::vector<Line> lines)
+// Intersect consecutive lines, returns false if two consecutive lines are parallel
+bool getQuadFromLines(const Line lines[4], Quadrangle& quad)
 {
-	Quadrangle quad;
+	Point* corners[4] = {&quad.p0, &quad.p1, &quad.p2, &quad.p3};
 	for(int i=0;i<4;i++)
 	{
-		Line l0 = lines[i];
-		Line l1 = lines[(i+1)%4];
+		const Line& l0 = lines[i];
+		const Line& l1 = lines[(i+1)%4];
 		
 		float l0a = l0.p1.y-l0.p0.y;
 		float l0b = l0.p0.x-l0.p1.x;
@@ -559,181 +818,202 @@ Quadrangle getQuadFromLines(std::vector<Line> lines)
 
 		float det = l0a*l1b-l1a*l0b;
 		if(det==0)
-		{
-			std::cout << "PARALLEL LINES" << std::endl;
-			exit(1);
-		}else
-		{
-			float x = (l1b*l0c-l0b*l1c)/det;
-			float y = (l0a*l1c-l1a*l0c)/det;
-			switch(i)
-			{
-				case 0:
-					quad.p0 = {x,y};
-					break;
-				case 1:
-					quad.p1 = {x,y};
-					break;
-				case 2:
-					quad.p2 = {x,y};
-					break;
-				case 3:
-					quad.p3 = {x,y};
-					break;
-			}
-		}
+			return false;
+
+		float x = (l1b*l0c-l0b*l1c)/det;
+		float y = (l0a*l1c-l1a*l0c)/det;
+		*corners[i] = {x,y};
 	}
-	return quad;
+	return true;
 }
 
-std::vector<Quadrangle> findQuadrangles(std::vector<Line> lines, std::vector<std::vector<int>> connections, int depth=0, std::vector<int> currList={})
+// Enumerate every 4-cycle of the line graph exactly once.
+// A cycle is only reported in its canonical order: the first line has the
+// smallest index and the second line has a smaller index than the fourth.
+// The search uses a fixed size stack of neighbor cursors (one per depth).
+// The filter cascade runs during the search: a partial path whose sides fail
+// the proximity or orientation stages is not extended.
+void findQuadrangles(const std::vector<Line>& lines, const LineGraph& connections, std::vector<Quadrangle>& result,
+		FrameArena& arena, const QuadFilter& filter=QuadFilter(), QuadStats* stats=nullptr)
 {
-	std::vector<Quadrangle> result;
+	result.clear();
+	QuadStats counters;
+	long cycles = 0;
 
-	if(depth == 0)
-	{
-		// First call
-		for(int i=0; i<(int)lines.size(); i++)
-		{
-			std::vector<int> lineList = {i};
-			std::vector<Quadrangle> res = findQuadrangles(lines, connections, depth+1, lineList);
-			result.insert(result.end(), res.begin(), res.end());
-		}
-	}
-	else if(depth < 4)
+	QuadSide* sides = arena.allocate<QuadSide>(lines.size());
+	for(int i=0;i<(int)lines.size();i++)
+		sides[i] = makeQuadSide(lines[i]);
+
+	// Path stages for the line placed at depth (1..3)
+	int path[4];
+	auto extendable = [&](int depth)
 	{
-		// For each connection until 5...
-		for(auto lineIndex : connections[currList.back()])
+		const QuadSide& side = sides[path[depth]];
+		if(sideAngle(sides[path[depth-1]], side)<filter.minCornerAngle ||
+			(depth>=2 && sideAngle(sides[path[depth-2]], side)>filter.maxOppositeAngle))
 		{
-			bool skip=false;
-			for(auto curr : currList)
-				if(lineIndex==curr)
-				{
-					skip=true;
-					break;
-				}
-			if(skip)continue;
-
-			std::vector<int> lineList = currList;
-			lineList.push_back(lineIndex);
-			std::vector<Quadrangle> res = findQuadrangles(lines, connections, depth+1, lineList);
-			result.insert(result.end(), res.begin(), res.end());
+			counters.orientation++;
+			return false;
 		}
-	}
-	else if(depth == 4)
-	{
-		// Check if last one connects with first
-		bool closed=false;
-		for(auto connection : connections[currList.back()])
+		if(depth>=2 && !passesProximity(sides[path[depth-2]], sides[path[depth-1]], side, filter))
 		{
-			if(connection==currList[0])
-				closed = true;
+			counters.proximity++;
+			return false;
 		}
-		if(!closed)
-			return {};
-
-		//std::cout << "Index: " << 
-		//	currList[0] << " " << 
-		//	currList[1] << " " << 
-		//	currList[2] << " " << 
-		//	currList[3] << " " << 
-		//	std::endl;
-	
-		// Intersect lines to find points
-		std::vector<Point> interserctionPoints;
-
-		//std::cout << "Quad: " << 
-		//	"(" << lines[currList[0]].p0.x << "," << lines[currList[0]].p0.y << ")-(" << lines[currList[0]].p1.x << "," << lines[currList[0]].p1.y << ") " << 
-		//	"(" << lines[currList[1]].p0.x << "," << lines[currList[1]].p0.y << ")-(" << lines[currList[1]].p1.x << "," << lines[currList[1]].p1.y << ") " << 
-		//	"(" << lines[currList[2]].p0.x << "," << lines[currList[2]].p0.y << ")-(" << lines[currList[2]].p1.x << "," << lines[currList[2]].p1.y << ") " << 
-		//	"(" << lines[currList[3]].p0.x << "," << lines[currList[3]].p0.y << ")-(" << lines[currList[3]].p1.x << "," << lines[currList[3]].p1.y << ") " << 
-		//	std::endl;
-
-		std::vector<Line> quadLines = {lines[currList[0]], lines[currList[1]], lines[currList[2]], lines[currList[3]]};
-
-		// Check if it intersects with first and has no repeted line
-		result.push_back(getQuadFromLines(quadLines));
-	}
-
-	// TODO filter repeated quadrangles
-	
-	return result;
-}
+		return true;
+	};
 
-std::vector<Quadrangle> computeQuadrangles(std::vector<Line> lines)
-{
-	std::vector<std::vector<int>> connectedLines(lines.size());
-	float maxDist = 5;
-	float minDiffA = 0.5;
-
-	// Find connected lines
-	for(int i=0; i<(int)lines.size(); i++)
+	const int* cursor[4];
+	const int* last[4];
+	for(int first=0; first<connections.size(); first++)
 	{
-		Line l0 = lines[i];
-		for(int j=0; j<(int)lines.size(); j++)
+		path[0] = first;
+		// Neighbor lists are sorted, lines with smaller index than the first are skipped at once
+		cursor[1] = std::upper_bound(connections.begin(first), connections.end(first), first);
+		last[1] = connections.end(first);
+		int depth = 1;
+		while(depth>0)
 		{
-			if(i==j)
+			if(cursor[depth]==last[depth])
+			{
+				depth--;
 				continue;
-			bool skip=false;
-			for(int k=0;k<connectedLines[i].size();k++)
-				if(j==connectedLines[i][k])
-					skip = true;
-			if(skip)continue;
-
-			Line l1 = lines[j];
-			// Check distance
-			if(minLineDistance(l0, l1)>maxDist)
+			}
+			int lineIndex = *cursor[depth]++;
+			if(depth==3 && lineIndex<=path[1])
+				continue;
+			path[depth] = lineIndex;
+			if(!extendable(depth))
 				continue;
 
-			// (TODO deal with vertical lines)
-			if(l0.p1.x==l0.p0.x || l1.p1.x==l1.p0.x)
+			if(depth<3)
+			{
+				depth++;
+				cursor[depth] = std::upper_bound(connections.begin(lineIndex), connections.end(lineIndex), first);
+				last[depth] = connections.end(lineIndex);
 				continue;
+			}
 
-			// Angular coeficient 
-			float l0a = (l0.p1.y-l0.p0.y)/(l0.p1.x-l0.p0.x);
-			float l1a = (l1.p1.y-l1.p0.y)/(l1.p1.x-l1.p0.x);
+			// Check if last one connects with first
+			if(!std::binary_search(connections.begin(lineIndex), connections.end(lineIndex), first))
+				continue;
+			cycles++;
 
-			if(std::abs(l0a-l1a)<minDiffA)
+			// Closing corner
+			if(sideAngle(sides[path[3]], sides[path[0]])<filter.minCornerAngle)
+			{
+				counters.orientation++;
+				continue;
+			}
+			if(!passesProximity(sides[path[2]], sides[path[3]], sides[path[0]], filter) ||
+				!passesProximity(sides[path[3]], sides[path[0]], sides[path[1]], filter))
+			{
+				counters.proximity++;
 				continue;
+			}
 
-			connectedLines[i].push_back(j);
-			connectedLines[j].push_back(i);
+			// Intersect lines to find points
+			Line quadLines[4] = {lines[path[0]], lines[path[1]], lines[path[2]], lines[path[3]]};
+			Quadrangle quad;
+			if(!getQuadFromLines(quadLines, quad) ||
+				!std::isfinite(quad.p0.x+quad.p0.y+quad.p1.x+quad.p1.y+quad.p2.x+quad.p2.y+quad.p3.x+quad.p3.y))
+			{
+				counters.degenerate++;
+				continue;
+			}
+			const Point corners[4] = {quad.p0, quad.p1, quad.p2, quad.p3};
+			if(!passesConvexity(corners))
+				counters.convexity++;
+			else if(!passesSize(corners, filter))
+				counters.size++;
+			else if(!passesAspectRatio(corners, filter))
+				counters.aspectRatio++;
+			else
+			{
+				counters.accepted++;
+				result.push_back(quad);
+			}
 		}
 	}
 
+	PROFILE_COUNT(PROFILE_CYCLES, cycles);
+	PROFILE_COUNT(PROFILE_QUADS, result.size());
+	if(stats!=nullptr)
+		stats->merge(counters);
+}
+
+std::vector<Quadrangle> findQuadrangles(const std::vector<Line>& lines, const LineGraph& connections,
+		const QuadFilter& filter=QuadFilter(), QuadStats* stats=nullptr)
+{
+	FrameArena arena;
+	std::vector<Quadrangle> result;
+	findQuadrangles(lines, connections, result, arena, filter, stats);
+	return result;
+}
+
+// connectedLines is only a workspace, reusing it across frames keeps its memory
+void computeQuadrangles(const std::vector<Line>& lines, std::vector<Quadrangle>& result, LineGraph& connectedLines,
+		FrameArena& arena, const QuadFilter& filter=QuadFilter(), QuadStats* stats=nullptr)
+{
+	float maxDist = 5;
+	float minDiffA = 0.5;
+
+	// Find connected lines (only endpoints in neighboring grid cells are compared)
+	{
+		PROFILE_SCOPE("lineGraph");
+		buildLineGraph(lines, maxDist, minDiffA, connectedLines, arena);
+	}
+	PROFILE_COUNT(PROFILE_GRAPH_EDGES, connectedLines.neighbors.size()/2);
+
 	//for(int i=0; i<connectedLines.size();i++)
 	//{
 	//	std::cout << i << "-> ";
-	//	for(int j=0; j<connectedLines[i].size();j++)
+	//	for(const int* it=connectedLines.begin(i); it!=connectedLines.end(i); it++)
 	//	{
-	//		std::cout << connectedLines[i][j] << " ";
+	//		std::cout << *it << " ";
 	//	}
 	//	std::cout << std::endl;
 	//}
 
-	std::vector<Quadrangle> result = findQuadrangles(lines, connectedLines);
+	PROFILE_SCOPE("findQuadrangles");
+	findQuadrangles(lines, connectedLines, result, arena, filter, stats);
 
 	//for(auto line : lines)
 	//	result.push_back({line.p0, line.p1, line.p0, line.p1});
+}
 
+std::vector<Quadrangle> computeQuadrangles(const std::vector<Line>& lines, const QuadFilter& filter=QuadFilter(), QuadStats* stats=nullptr)
+{
+	FrameArena arena;
+	LineGraph connectedLines;
+	std::vector<Quadrangle> result;
+	computeQuadrangles(lines, result, connectedLines, arena, filter, stats);
 	return result;
 }
 
-void drawLines(Image& image, std::vector<Line> lines)
+//--------------------//
+//------- Draw -------//
+//--------------------//
+// Lines are clipped to the view
+void drawLines(ImageView image, const std::vector<Line>& lines)
 {
 	// https://stackoverflow.com/questions/10060046/drawing-lines-with-bresenhams-line-algorithm
-	for(auto line : lines)
+	for(const auto& line : lines)
 	{
-		Point p0 = {int(line.p0.x), int(line.p0.y)};
-		Point p1 = {int(line.p1.x), int(line.p1.y)};
-		int dx = p1.x - p0.x;
-		int dy = p1.y - p0.y;
+		if(!std::isfinite(line.p0.x) || !std::isfinite(line.p0.y) || !std::isfinite(line.p1.x) || !std::isfinite(line.p1.y))
+			continue;
+
+		int x = int(line.p0.x);
+		int y = int(line.p0.y);
+		int dx = int(line.p1.x) - x;
+		int dy = int(line.p1.y) - y;
 
 		int dLong = abs(dx);
 		int dShort = abs(dy);
 
-		int offsetLong = dx > 0 ? 1 : -1;
-		int offsetShort = dy > 0 ? image.width : -image.width;
+		// Steps as (x,y) pairs
+		int offsetLong[2] = {dx > 0 ? 1 : -1, 0};
+		int offsetShort[2] = {0, dy > 0 ? 1 : -1};
 
 		if(dLong < dShort)
 		{
@@ -742,29 +1022,40 @@ void drawLines(Image& image, std::vector<Line> lines)
 		}
 
 		int error = dLong/2;
-		int index = p0.y*image.width*image.channels + p0.x*image.channels;
-		const int offset[] = {offsetLong, offsetLong + offsetShort};
+		const int offset[2][2] = {{offsetLong[0], offsetLong[1]}, {offsetLong[0] + offsetShort[0], offsetLong[1] + offsetShort[1]}};
 		const int abs_d[]  = {dShort, dShort - dLong};
 		for(int i = 0; i <= dLong; ++i)
 		{
-			for(int c=0;c<image.channels;c++)
-				if(index+c<image.buffer.size())
-					image.buffer[index+c] = 255;
+			if(x>=0 && y>=0 && x<(int)image.width && y<(int)image.height)
+				for(int c=0;c<image.channels;c++)
+					image.at(x, y, c) = 255;
 
 			const int errorIsTooBig = error >= dLong;
-			index += offset[errorIsTooBig]*image.channels;
+			x += offset[errorIsTooBig][0];
+			y += offset[errorIsTooBig][1];
 			error += abs_d[errorIsTooBig];
 		}
 	}
 }
 
-Image drawQuadrangles(Image image, std::vector<Quadrangle> quadrangles)
+void drawLines(Image& image, const std::vector<Line>& lines)
 {
-	Image result = image;
-	for(auto q : quadrangles)
+	drawLines(image.view(), lines);
+}
+
+// In place
+void drawQuadrangles(ImageView image, const std::vector<Quadrangle>& quadrangles)
+{
+	for(const auto& q : quadrangles)
 	{
-		drawLines(result, {{q.p0, q.p1}, {q.p1, q.p2}, {q.p2, q.p3}, {q.p3, q.p0}});
+		drawLines(image, {{q.p0, q.p1}, {q.p1, q.p2}, {q.p2, q.p3}, {q.p3, q.p0}});
 	}
+}
+
+Image drawQuadrangles(const Image& image, const std::vector<Quadrangle>& quadrangles)
+{
+	Image result = image;
+	drawQuadrangles(result.view(), quadrangles);
 	return result;
 }
 
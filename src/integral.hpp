@@ -0,0 +1,225 @@
+//--------------------------------------------------
+// Robot Simulator
+// integral.hpp
+// Date: 17/10/2026
+// By Breno Cunha Queiroz
+//--------------------------------------------------
+#ifndef INTEGRAL_H
+#define INTEGRAL_H
+#include <vector>
+#include <iostream>
+#include <cstdint>
+#include <algorithm>
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+#include "helpers.hpp"
+#include "threadPool.hpp"
+#include "arena.hpp"
+
+//--------------------//
+//- Summed area table //
+//--------------------//
+// sums[y*stride + x] is the sum of the pixels in [0,x)x[0,y), so row and column
+// 0 are zero. The sums wrap around modulo 2^32, the box sums stay exact as long
+// as a box has less than 2^24 pixels, whatever the size of the image.
+struct IntegralImage
+{
+	int width = 0;// Of the image, the table is (width+1)x(height+1)
+	int height = 0;
+	int stride = 0;
+	uint32_t* sums = nullptr;// Arena memory
+
+	const uint32_t* row(int y) const { return sums + size_t(y)*stride; }
+	uint32_t* row(int y) { return sums + size_t(y)*stride; }
+
+	// Sum of the pixels in [x0,x1)x[y0,y1)
+	uint32_t boxSum(int x0, int y0, int x1, int y1) const
+	{
+		const uint32_t* top = row(y0);
+		const uint32_t* bottom = row(y1);
+		return bottom[x1]-bottom[x0]-top[x1]+top[x0];
+	}
+};
+
+// sums[x+1] = prev[x+1] + src[0]+...+src[x] for x in [0,width), sums[0] = 0
+void integralRow(const unsigned char* src, int width, const uint32_t* prev, uint32_t* sums)
+{
+	sums[0] = 0;
+	uint32_t running = 0;
+	int x=0;
+#if defined(__SSE2__)
+	// Prefix sums of 8 pixels in 16 bits (at most 8*255) with three shifted adds,
+	// then widened and offset by the running sum of the row
+	const __m128i zero = _mm_setzero_si128();
+	__m128i carry = _mm_setzero_si128();
+	for(;x+8<=width;x+=8)
+	{
+		__m128i v = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(src+x)), zero);
+		v = _mm_add_epi16(v, _mm_slli_si128(v, 2));
+		v = _mm_add_epi16(v, _mm_slli_si128(v, 4));
+		v = _mm_add_epi16(v, _mm_slli_si128(v, 8));
+		__m128i lo = _mm_add_epi32(carry, _mm_unpacklo_epi16(v, zero));
+		__m128i hi = _mm_add_epi32(carry, _mm_unpackhi_epi16(v, zero));
+		carry = _mm_shuffle_epi32(hi, 0xFF);
+		_mm_storeu_si128((__m128i*)(sums+x+1), _mm_add_epi32(lo, _mm_loadu_si128((const __m128i*)(prev+x+1))));
+		_mm_storeu_si128((__m128i*)(sums+x+5), _mm_add_epi32(hi, _mm_loadu_si128((const __m128i*)(prev+x+5))));
+	}
+	running = _mm_cvtsi128_si32(carry);
+#endif
+	for(;x<width;x++)
+	{
+		running += src[x];
+		sums[x+1] = prev[x+1]+running;
+	}
+}
+
+// The table is allocated in the arena. With several threads every band of rows
+// is summed on its own, then the bands are offset by the last row of the bands
+// above them (a two level prefix sum).
+void computeIntegralImage(ConstImageView image, IntegralImage& integral, FrameArena& arena, int numThreads=1)
+{
+	if(image.channels!=1)
+	{
+		std::cout << "[computeIntegralImage] The image should have one channel. Nothing done" << std::endl;
+		return;
+	}
+
+	integral.width = image.width;
+	integral.height = image.height;
+	integral.stride = (image.width+1+15)&~15;// Cache line aligned rows
+	integral.sums = arena.allocate<uint32_t>(size_t(integral.stride)*(image.height+1));
+	std::fill(integral.sums, integral.sums+image.width+1, 0);
+
+	int width = image.width;
+	int height = image.height;
+	int bands = std::max(1, std::min(numThreads, height/64));// Bands too small are not worth the second pass
+	auto bandStart = [&](int i) { return int(int64_t(height)*i/bands); };
+	auto sumBand = [&](int i)
+	{
+		// Row 0 is zero, so every band starts from it
+		for(int y=bandStart(i);y<bandStart(i+1);y++)
+			integralRow(image.row(y), width, integral.row(y==bandStart(i) ? 0 : y), integral.row(y+1));
+	};
+	if(bands==1)
+	{
+		sumBand(0);
+		return;
+	}
+	threadPool().parallelFor(bands, sumBand);
+
+	// Offset of band i: the last row of band i-1 once offset itself
+	uint32_t* offsets = arena.allocate<uint32_t>(size_t(bands)*(width+1));
+	std::fill(offsets, offsets+width+1, 0);
+	for(int i=1;i<bands;i++)
+	{
+		const uint32_t* previous = &offsets[(i-1)*(width+1)];
+		const uint32_t* last = integral.row(bandStart(i));
+		uint32_t* offset = &offsets[i*(width+1)];
+		for(int x=0;x<=width;x++)
+			offset[x] = previous[x]+last[x];
+	}
+	threadPool().parallelFor(bands-1, [&](int b)
+	{
+		int i = b+1;
+		const uint32_t* offset = &offsets[i*(width+1)];
+		for(int y=bandStart(i);y<bandStart(i+1);y++)
+		{
+			uint32_t* sums = integral.row(y+1);
+			for(int x=0;x<=width;x++)
+				sums[x] += offset[x];
+		}
+	});
+}
+
+// Scalar reference, computeIntegralImage() must match it
+std::vector<uint32_t> integralImageScalar(ConstImageView image)
+{
+	std::vector<uint32_t> sums((image.width+1)*(image.height+1), 0);
+	for(int y=0;y<image.height;y++)
+	{
+		uint32_t running = 0;
+		for(int x=0;x<image.width;x++)
+		{
+			running += image.row(y)[x];
+			sums[(y+1)*(image.width+1) + x+1] = sums[y*(image.width+1) + x+1] + running;
+		}
+	}
+	return sums;
+}
+
+//--------------------//
+//------ Windows -----//
+//--------------------//
+// Sums and pixel counts of the windows [x-radius,x+radius]x[y-radius,y+radius]
+// clipped to the image, for every x of row y. This is the O(1) per pixel part
+// of the box filters, whatever the radius.
+void windowSumsRow(const IntegralImage& integral, int y, int radius, uint32_t* sums, uint32_t* counts)
+{
+	int width = integral.width;
+	int y0 = std::max(0, y-radius);
+	int y1 = std::min(integral.height, y+radius+1);
+	const uint32_t* top = integral.row(y0);
+	const uint32_t* bottom = integral.row(y1);
+	uint32_t rows = y1-y0;
+
+	// Windows clipped on the left or on the right
+	int interiorStart = std::min(width, radius);
+	int interiorEnd = std::max(interiorStart, width-radius);
+	auto clipped = [&](int x)
+	{
+		int x0 = std::max(0, x-radius);
+		int x1 = std::min(width, x+radius+1);
+		sums[x] = bottom[x1]-bottom[x0]-top[x1]+top[x0];
+		counts[x] = rows*(x1-x0);
+	};
+	for(int x=0;x<interiorStart;x++)
+		clipped(x);
+	uint32_t count = rows*(2*radius+1);
+	for(int x=interiorStart;x<interiorEnd;x++)
+	{
+		sums[x] = bottom[x+radius+1]-bottom[x-radius]-top[x+radius+1]+top[x-radius];
+		counts[x] = count;
+	}
+	for(int x=interiorEnd;x<width;x++)
+		clipped(x);
+}
+
+//--------------------//
+//---- Box filter ----//
+//--------------------//
+// Rounded mean of the (2*radius+1)^2 window around every pixel, the windows are
+// clipped at the borders so the output has the size of the input
+void boxFilter(ConstImageView image, ImageView result, int radius, FrameArena& arena, int numThreads=1)
+{
+	if(!sameSize(image, result) || image.channels!=1 || result.channels!=1 || radius<0)
+	{
+		std::cout << "[boxFilter] Incompatible images. Nothing done" << std::endl;
+		return;
+	}
+
+	IntegralImage integral;
+	computeIntegralImage(image, integral, arena, numThreads);
+	parallelRows(image.height, numThreads, [&](int y0, int y1)
+	{
+		uint32_t* sums = arena.allocate<uint32_t>(image.width);
+		uint32_t* counts = arena.allocate<uint32_t>(image.width);
+		for(int y=y0;y<y1;y++)
+		{
+			windowSumsRow(integral, y, radius, sums, counts);
+			unsigned char* dst = result.row(y);
+			for(int x=0;x<image.width;x++)
+				dst[x] = (sums[x]+counts[x]/2)/counts[x];
+		}
+	});
+}
+
+Image boxFilter(const Image& image, int radius, int numThreads=1)
+{
+	FrameArena arena;
+	Image result = createImage(image.width, image.height, 1);
+	boxFilter(image.view(), result.view(), radius, arena, numThreads);
+	return result;
+}
+
+#endif// INTEGRAL_H
@@ -0,0 +1,204 @@
+//--------------------------------------------------
+// Robot Simulator
+// labeling.hpp
+// Date: 17/10/2026
+// By Breno Cunha Queiroz
+//--------------------------------------------------
+#ifndef LABELING_H
+#define LABELING_H
+#include <vector>
+#include <cstdlib>
+#include <cstdint>
+#include <climits>
+#include <algorithm>
+#include "helpers.hpp"
+#include "arena.hpp"
+
+// Running moments of a component, enough to fit its principal axis without the edgel list
+struct ComponentMoments
+{
+	int64_t sumX = 0;
+	int64_t sumY = 0;
+	int64_t sumXsquare = 0;
+	int64_t sumYsquare = 0;
+	int64_t sumXY = 0;
+	int minX = INT_MAX;
+	int minY = INT_MAX;
+	int maxX = INT_MIN;
+	int maxY = INT_MIN;
+	int count = 0;
+
+	void add(int x, int y)
+	{
+		sumX += x;
+		sumY += y;
+		sumXsquare += int64_t(x)*x;
+		sumYsquare += int64_t(y)*y;
+		sumXY += int64_t(x)*y;
+		minX = std::min(minX, x);
+		minY = std::min(minY, y);
+		maxX = std::max(maxX, x);
+		maxY = std::max(maxY, y);
+		count++;
+	}
+
+	void merge(const ComponentMoments& other)
+	{
+		sumX += other.sumX;
+		sumY += other.sumY;
+		sumXsquare += other.sumXsquare;
+		sumYsquare += other.sumYsquare;
+		sumXY += other.sumXY;
+		minX = std::min(minX, other.minX);
+		minY = std::min(minY, other.minY);
+		maxX = std::max(maxX, other.maxX);
+		maxY = std::max(maxY, other.maxY);
+		count += other.count;
+	}
+};
+
+// Circular distance between two orientation codes
+int orientationDistance(unsigned char a, unsigned char b)
+{
+	int error = std::abs(a-b);
+	if(error>127)
+		error = 255-error;
+	return error;
+}
+
+// Offset from b to a on the same circle, in [-127,127]: |offset| is orientationDistance(a, b)
+int orientationOffset(unsigned char a, unsigned char b)
+{
+	int offset = a-b;
+	if(offset>127)
+		offset -= 255;
+	else if(offset<-127)
+		offset += 255;
+	return offset;
+}
+
+// Orientation of the first edgel of a component, and the range of the offsets
+// of its edgels from it
+struct ComponentSeed
+{
+	unsigned char orientation;
+	int low;
+	int high;
+};
+
+int findRoot(int* parent, int i)
+{
+	while(parent[i]!=i)
+	{
+		parent[i] = parent[parent[i]];// Path halving
+		i = parent[i];
+	}
+	return i;
+}
+
+// Single pass union-find labeling of 4-connected edgels.
+// Like the old flood fill, every edgel of a component is within tolerance of
+// the orientation of its first (seed) edgel: an edgel only joins a component
+// within tolerance of its seed, and two components only merge if all the
+// edgels of the newer one are within tolerance of the seed of the older one
+// (the offset range of each component is kept for that). When they cannot,
+// the edgel joins the component with the closest seed and both stay apart.
+// The rule is the one of the flood fill but not the partition: the edgels are
+// claimed in raster order instead of flood order, so an edgel within tolerance
+// of two seeds can end in a different component (see labelingCheck).
+// Only two rows of labels are kept; the moments of each component are
+// accumulated on the fly and merged into the root on every union.
+// The components are returned in raster order of their first edgel, all the
+// scratch memory comes from the arena.
+void labelComponents(ConstImageView edgels, int tolerance, ArenaVector<ComponentMoments>& result, FrameArena& arena)
+{
+	int width = edgels.width;
+	int* prevLabels = arena.allocate<int>(width);
+	int* currLabels = arena.allocate<int>(width);
+	std::fill(prevLabels, prevLabels+width, -1);
+	ArenaVector<int> parent(arena, 1024);
+	ArenaVector<ComponentSeed> seed(arena, 1024);
+	ArenaVector<ComponentMoments> moments(arena, 1024);
+
+	// Provisional labels, roots are always the oldest label
+	for(int y=0;y<(int)edgels.height;y++)
+	{
+		const unsigned char* row = edgels.row(y);
+		for(int x=0;x<width;x++)
+		{
+			unsigned char value = row[x];
+			if(value==0)
+			{
+				currLabels[x] = -1;
+				continue;
+			}
+
+			int left = x>0 ? currLabels[x-1] : -1;
+			int up = prevLabels[x];
+			if(left>=0)
+			{
+				left = findRoot(parent.data(), left);
+				if(orientationDistance(value, seed[left].orientation)>tolerance)
+					left = -1;
+			}
+			if(up>=0)
+			{
+				up = findRoot(parent.data(), up);
+				if(orientationDistance(value, seed[up].orientation)>tolerance)
+					up = -1;
+			}
+
+			int label;
+			if(left>=0 && up>=0 && left!=up)
+			{
+				int root = std::min(left, up);
+				int other = std::max(left, up);
+				// Offsets of the edgels of other from the seed of root (no wrap while tolerance<43)
+				int shift = orientationOffset(seed[other].orientation, seed[root].orientation);
+				int low = seed[other].low+shift;
+				int high = seed[other].high+shift;
+				if(low>=-tolerance && high<=tolerance)
+				{
+					parent[other] = root;
+					moments[root].merge(moments[other]);
+					seed[root].low = std::min(seed[root].low, low);
+					seed[root].high = std::max(seed[root].high, high);
+					label = root;
+				}
+				else// Join the component with the closest seed
+					label = orientationDistance(value, seed[left].orientation)<=orientationDistance(value, seed[up].orientation) ? left : up;
+			}
+			else if(left>=0 || up>=0)
+				label = left>=0 ? left : up;
+			else
+			{
+				label = parent.size();
+				parent.push_back(label);
+				seed.push_back({value, 0, 0});
+				moments.push_back({});
+			}
+			int offset = orientationOffset(value, seed[label].orientation);
+			seed[label].low = std::min(seed[label].low, offset);
+			seed[label].high = std::max(seed[label].high, offset);
+			moments[label].add(x, y);
+			currLabels[x] = label;
+		}
+		std::swap(prevLabels, currLabels);
+	}
+
+	// Compact the roots
+	result.clear();
+	for(int i=0;i<(int)parent.size();i++)
+		if(parent[i]==i)
+			result.push_back(moments[i]);
+}
+
+std::vector<ComponentMoments> labelComponents(ConstImageView edgels, int tolerance=25)
+{
+	FrameArena arena;
+	ArenaVector<ComponentMoments> components(arena);
+	labelComponents(edgels, tolerance, components, arena);
+	return std::vector<ComponentMoments>(components.begin(), components.end());
+}
+
+#endif// LABELING_H
@@ -0,0 +1,202 @@
+//--------------------------------------------------
+// Robot Simulator
+// lineGraph.hpp
+// Date: 17/10/2026
+// By Breno Cunha Queiroz
+//--------------------------------------------------
+#ifndef LINE_GRAPH_H
+#define LINE_GRAPH_H
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include "helpers.hpp"
+#include "arena.hpp"
+
+// Line connectivity in compressed sparse row layout:
+// neighbors of line i are neighbors[offsets[i]..offsets[i+1]), sorted by index.
+// A graph rebuilt in place keeps its capacity.
+struct LineGraph
+{
+	std::vector<int> offsets;
+	std::vector<int> neighbors;
+
+	int size() const { return (int)offsets.size()-1; }
+	int degree(int i) const { return offsets[i+1]-offsets[i]; }
+	const int* begin(int i) const { return neighbors.data()+offsets[i]; }
+	const int* end(int i) const { return neighbors.data()+offsets[i+1]; }
+};
+
+// Line endpoints bucketed in a uniform grid, endpoint e of line i has index 2*i+e
+struct EndpointGrid
+{
+	float minX = 0;
+	float minY = 0;
+	float cellSize = 1;
+	int cols = 0;
+	int rows = 0;
+	// Arena memory: endpoints of cell c are endpoints[cellStart[c]..cellStart[c+1])
+	int* cellStart = nullptr;
+	int* endpoints = nullptr;
+
+	// Returns false for non finite points, they are never bucketed
+	bool cell(Point p, int& cx, int& cy) const
+	{
+		if(!std::isfinite(p.x) || !std::isfinite(p.y))
+			return false;
+		cx = std::min(cols-1, std::max(0, int((p.x-minX)/cellSize)));
+		cy = std::min(rows-1, std::max(0, int((p.y-minY)/cellSize)));
+		return true;
+	}
+};
+
+Point lineEndpoint(const Line& line, int e)
+{
+	return e==0 ? line.p0 : line.p1;
+}
+
+// Cells are wider than maxDist, so close endpoints are always in neighboring cells
+EndpointGrid buildEndpointGrid(const std::vector<Line>& lines, float maxDist, FrameArena& arena)
+{
+	static constexpr int MAX_GRID_SIDE = 1024;
+	EndpointGrid grid;
+
+	float maxX = -INFINITY;
+	float maxY = -INFINITY;
+	grid.minX = INFINITY;
+	grid.minY = INFINITY;
+	for(const auto& line : lines)
+		for(int e=0;e<2;e++)
+		{
+			Point p = lineEndpoint(line, e);
+			if(!std::isfinite(p.x) || !std::isfinite(p.y))
+				continue;
+			grid.minX = std::min(grid.minX, p.x);
+			grid.minY = std::min(grid.minY, p.y);
+			maxX = std::max(maxX, p.x);
+			maxY = std::max(maxY, p.y);
+		}
+	if(maxX<grid.minX)
+	{
+		// No finite endpoint
+		grid.minX = grid.minY = 0;
+		maxX = maxY = 0;
+	}
+
+	// Far away (extrapolated) endpoints only make the cells larger
+	float span = std::max(maxX-grid.minX, maxY-grid.minY);
+	grid.cellSize = std::max(std::max(maxDist*1.01f, 1e-3f), span/MAX_GRID_SIDE);// Margin for rounding
+	grid.cols = int((maxX-grid.minX)/grid.cellSize)+1;
+	grid.rows = int((maxY-grid.minY)/grid.cellSize)+1;
+
+	// Counting sort of the endpoints by cell
+	int endpointCount = lines.size()*2;
+	int cells = grid.cols*grid.rows;
+	int* endpointCell = arena.allocate<int>(endpointCount);
+	grid.cellStart = arena.allocate<int>(cells+1);
+	std::fill(endpointCell, endpointCell+endpointCount, -1);
+	std::fill(grid.cellStart, grid.cellStart+cells+1, 0);
+	for(int i=0;i<endpointCount;i++)
+	{
+		int cx, cy;
+		if(grid.cell(lineEndpoint(lines[i/2], i%2), cx, cy))
+		{
+			endpointCell[i] = cy*grid.cols + cx;
+			grid.cellStart[endpointCell[i]+1]++;
+		}
+	}
+	for(int c=0;c<cells;c++)
+		grid.cellStart[c+1] += grid.cellStart[c];
+	grid.endpoints = arena.allocate<int>(grid.cellStart[cells]);
+	int* fill = arena.allocate<int>(cells);
+	std::copy(grid.cellStart, grid.cellStart+cells, fill);
+	for(int i=0;i<endpointCount;i++)
+		if(endpointCell[i]>=0)
+			grid.endpoints[fill[endpointCell[i]]++] = i;
+
+	return grid;
+}
+
+// Same criteria as the old all pairs search: some endpoint pair closer than maxDist,
+// no vertical line and angular coefficients differing by at least minDiffA
+void buildLineGraph(const std::vector<Line>& lines, float maxDist, float minDiffA, LineGraph& graph, FrameArena& arena)
+{
+	int n = lines.size();
+	EndpointGrid grid = buildEndpointGrid(lines, maxDist, arena);
+
+	// Candidate pairs (i<j) from the 3x3 cells around each endpoint
+	ArenaVector<int> edges(arena, 4*n);// Pairs i,j
+	int* lastTested = arena.allocate<int>(n);
+	std::fill(lastTested, lastTested+n, -1);
+	for(int i=0;i<n;i++)
+	{
+		const Line& l0 = lines[i];
+		for(int e=0;e<2;e++)
+		{
+			Point p = lineEndpoint(l0, e);
+			int cx, cy;
+			if(!grid.cell(p, cx, cy))
+				continue;
+
+			for(int y=std::max(0, cy-1);y<=std::min(grid.rows-1, cy+1);y++)
+				for(int x=std::max(0, cx-1);x<=std::min(grid.cols-1, cx+1);x++)
+				{
+					int c = y*grid.cols + x;
+					for(int k=grid.cellStart[c];k<grid.cellStart[c+1];k++)
+					{
+						int endpoint = grid.endpoints[k];
+						int j = endpoint/2;
+						if(j<=i || lastTested[j]==i)
+							continue;
+
+						Point q = lineEndpoint(lines[j], endpoint%2);
+						float dx = q.x-p.x;
+						float dy = q.y-p.y;
+						if(!(sqrt(dx*dx+dy*dy)<=maxDist))
+							continue;
+						lastTested[j] = i;
+
+						const Line& l1 = lines[j];
+						// (TODO deal with vertical lines)
+						if(l0.p1.x==l0.p0.x || l1.p1.x==l1.p0.x)
+							continue;
+
+						// Angular coeficient
+						float l0a = (l0.p1.y-l0.p0.y)/(l0.p1.x-l0.p0.x);
+						float l1a = (l1.p1.y-l1.p0.y)/(l1.p1.x-l1.p0.x);
+						if(std::abs(l0a-l1a)<minDiffA)
+							continue;
+
+						edges.push_back(i);
+						edges.push_back(j);
+					}
+				}
+		}
+	}
+
+	// Build the CSR adjacency
+	graph.offsets.assign(n+1, 0);
+	for(auto v : edges)
+		graph.offsets[v+1]++;
+	for(int i=0;i<n;i++)
+		graph.offsets[i+1] += graph.offsets[i];
+	graph.neighbors.resize(edges.size());
+	int* fill = arena.allocate<int>(n);
+	std::copy(graph.offsets.begin(), graph.offsets.end()-1, fill);
+	for(int k=0;k<(int)edges.size();k+=2)
+	{
+		graph.neighbors[fill[edges[k]]++] = edges[k+1];
+		graph.neighbors[fill[edges[k+1]]++] = edges[k];
+	}
+	for(int i=0;i<n;i++)
+		std::sort(graph.neighbors.begin()+graph.offsets[i], graph.neighbors.begin()+graph.offsets[i+1]);
+}
+
+LineGraph buildLineGraph(const std::vector<Line>& lines, float maxDist, float minDiffA)
+{
+	FrameArena arena;
+	LineGraph graph;
+	buildLineGraph(lines, maxDist, minDiffA, graph, arena);
+	return graph;
+}
+
+#endif// LINE_GRAPH_H
@@ -7,45 +7,286 @@
 #include <iostream>
 #include <string>
 #include <vector>
+#include <cstdlib>
+#include <cstdio>
 #include "helpers.hpp"
-#include "imgProc.hpp"
+#include "detector.hpp"
+#include "batch.hpp"
+#include "png.hpp"
+#include "results.hpp"
+#include "stream.hpp"
+#include "tracker.hpp"
+#include "decoder.hpp"
+#include "profiler.hpp"
 
+struct Options
+{
+	int workers = hardwareThreads();
+	int compression = 0;
+	int renderEvery = -1;
+	int pyramidLevels = 0;
+	QuadEngine engine = QuadEngine::LINES;
+	bool decode = false;
+	CameraIntrinsics camera;// Poses off
+	double tagSize = 1;
+	std::string resultsPath;
+	std::string tracePath;
+	std::vector<std::string> inputs;
+	// Streaming
+	std::string stream;
+	StreamFormat streamFormat = StreamFormat::Y4M;
+	int streamWidth = 0;
+	int streamHeight = 0;
+	int fullScanEvery = 0;// Tracking off
+};
 
-void detectARtags(Image& image);
+int detectFiles(const Options& options, ResultWriter& results, TraceWriter& trace);
+int detectStream(const Options& options, ResultWriter& results, TraceWriter& trace);
 
-int main()
+// Usage: program [-j workers] [-p levels] [-e lines|contours] [-i] [-c fx,fy,cx,cy] [-m tagSize] [-o outputDir] [-z compression] [-r results] [-v renderEvery] [-T trace]
+//                [images, directories or .txt lists]
+//        program -s <stream> [-f y4m|gray8|rgb24] [-d WxH] [-p levels] [-e lines|contours] [-i] [-c fx,fy,cx,cy] [-m tagSize] [-t fullScanEvery] [-r results] [-v renderEvery] [-T trace]
+// Without inputs all the images in ../../gallery are processed.
+// -r writes the detections to a file (.bin for binary records, JSON Lines
+// otherwise, "-" for JSON Lines on stdout). With -r nothing is rendered unless
+// -v N asks for a debug overlay every N frames.
+// -s reads frames from stdin ("-") or a named pipe, raw formats need -d.
+// -p N finds the quadrangles N times 2x decimated and refines them at full resolution.
+// -e picks how the quadrangles are found: 4-cycles of the lines fitted on the
+// edgels (default) or the borders of the blobs of an adaptive threshold.
+// -i decodes the tag ids, quadrangles which are not tags are dropped.
+// -c estimates the pose of every tag with the camera intrinsics (pixels), the
+// translations are in the unit of -m (the side of the tag black border).
+// -t N tracks the tags of the previous frame and only scans the whole frame every N frames.
+// -T writes the stage timings and counters of every frame as a Chrome trace
+// (builds with ARTAG_PROFILE, which also print a summary table at the end).
+int main(int argc, char** argv)
 {
-	for(int i=1;i<=5;i++)
+	Options options;
+	for(int i=1;i<argc;i++)
 	{
-		Image image = readBmp(std::to_string(i));
-		detectARtags(image);
-		writePng(std::to_string(i), image);
+		std::string arg = argv[i];
+		if(arg=="-j" && i+1<argc)
+			options.workers = std::max(1, std::atoi(argv[++i]));
+		else if(arg=="-o" && i+1<argc)
+			setPngOutputDirectory(argv[++i]);
+		else if(arg=="-z" && i+1<argc)
+			options.compression = std::atoi(argv[++i]);
+		else if(arg=="-r" && i+1<argc)
+			options.resultsPath = argv[++i];
+		else if(arg=="-v" && i+1<argc)
+			options.renderEvery = std::max(0, std::atoi(argv[++i]));
+		else if(arg=="-p" && i+1<argc)
+			options.pyramidLevels = std::max(0, std::atoi(argv[++i]));
+		else if(arg=="-e" && i+1<argc)
+		{
+			std::string engine = argv[++i];
+			if(engine=="lines")
+				options.engine = QuadEngine::LINES;
+			else if(engine=="contours")
+				options.engine = QuadEngine::CONTOURS;
+			else
+			{
+				std::cerr << "Unknown quadrangle engine " << engine << std::endl;
+				return 1;
+			}
+		}
+		else if(arg=="-i")
+			options.decode = true;
+		else if(arg=="-T" && i+1<argc)
+			options.tracePath = argv[++i];
+		else if(arg=="-c" && i+1<argc)
+		{
+			CameraIntrinsics& c = options.camera;
+			if(sscanf(argv[++i], "%lf,%lf,%lf,%lf", &c.fx, &c.fy, &c.cx, &c.cy)!=4 || !c.valid())
+			{
+				std::cerr << "Camera intrinsics should be fx,fy,cx,cy" << std::endl;
+				return 1;
+			}
+		}
+		else if(arg=="-m" && i+1<argc)
+			options.tagSize = std::atof(argv[++i]);
+		else if(arg=="-t" && i+1<argc)
+			options.fullScanEvery = std::max(1, std::atoi(argv[++i]));
+		else if(arg=="-s" && i+1<argc)
+			options.stream = argv[++i];
+		else if(arg=="-f" && i+1<argc)
+		{
+			std::string format = argv[++i];
+			if(format=="y4m")
+				options.streamFormat = StreamFormat::Y4M;
+			else if(format=="gray8")
+				options.streamFormat = StreamFormat::GRAY8;
+			else if(format=="rgb24")
+				options.streamFormat = StreamFormat::RGB24;
+			else
+			{
+				std::cerr << "Unknown stream format " << format << std::endl;
+				return 1;
+			}
+		}
+		else if(arg=="-d" && i+1<argc)
+		{
+			if(sscanf(argv[++i], "%dx%d", &options.streamWidth, &options.streamHeight)!=2)
+			{
+				std::cerr << "Frame size should be WxH" << std::endl;
+				return 1;
+			}
+		}
+		else
+			options.inputs.push_back(arg);
 	}
 
-	return 0;
+	ResultWriter results;
+	if(!options.resultsPath.empty() && !results.open(options.resultsPath, resultFormatFromPath(options.resultsPath)))
+		return 1;
+	if(options.renderEvery<0)
+		options.renderEvery = results.enabled() ? 0 : 1;
+
+	TraceWriter trace;
+	if(!options.tracePath.empty())
+	{
+		if(!profilingEnabled())
+			std::cerr << "Built without ARTAG_PROFILE, the trace will be empty" << std::endl;
+		if(!trace.open(options.tracePath))
+			return 1;
+	}
+
+	return options.stream.empty() ? detectFiles(options, results, trace) : detectStream(options, results, trace);
 }
 
-void detectARtags(Image& image)
+int detectFiles(const Options& options, ResultWriter& results, TraceWriter& trace)
 {
-	//Image original = image;
-	// Convert to grayscale
-	image = grayscaleMax(image);
-	
-	// Smoothing the image with gaussian filter
-	std::vector<float> gaussianKernel = {	1, 4, 7, 4,1,
-											4,16,26,16,4,
-											7,26,41,26,7,
-											4,16,26,16,4,
-											1, 4, 7, 4,1};
-	for(unsigned int i=0;i<gaussianKernel.size();i++)
-		gaussianKernel[i]/=273;
-	image = convolution(image, gaussianKernel);
-	image = computeEdgels(image, 20);
-	std::vector<Line> lines = computeLines(image);
-	// TODO try to compelete fragmented lines
-	std::vector<Quadrangle> quadrangles = computeQuadrangles(lines);
-	image = grayscaleToColor(image);
-	image = drawQuadrangles(image, quadrangles);
-	//drawLines(image, lines);
+	std::vector<std::string> inputs = options.inputs;
+	if(inputs.empty())
+		inputs.push_back("../../gallery");
+	std::vector<std::string> files = listImages(inputs);
+
+	// With several frames in flight each frame runs single threaded
+	int stageThreads = options.workers>1 ? 1 : hardwareThreads();
+	std::vector<Detection> detections(files.size());
+	std::vector<Image> overlays(files.size());
+	std::vector<DecodeStats> decodeStats(files.size());
+	std::vector<FrameProfile> profiles(files.size());
+	QuadStats quadStats;
+	DecodeStats decodeTotal;
+	ProfileSummary profileSummary;
+	PngWriter writer(options.compression);
+	BatchStats stats = runBatch(files.size(), options.workers,
+		[&](int i)
+		{
+			ProfileFrame profileFrame(profiles[i], i);
+			PROFILE_SCOPE("frame");
+			// Detection reads the mapped file directly
+			BmpFile bmp;
+			{
+				PROFILE_SCOPE("readBmp");
+				if(!bmp.open(files[i]))
+					return;
+			}
+			// One detector per worker, its buffers are reused by the next files
+			thread_local Detector detector(options.pyramidLevels, stageThreads, options.engine);
+			Detection& detection = detector.detect(bmp.view());
+			if(options.decode)
+				decodeStats[i] = decodeTags(bmp.view(), detection, detector.arena());
+			if(options.camera.valid())
+				estimatePoses(detection, options.camera, options.tagSize);
+			if(options.renderEvery>0 && i%options.renderEvery==0)
+				overlays[i] = renderDetection(detection, stageThreads);
+			// The results are kept until committed, the edgels stay with the detector
+			detections[i].quadrangles = detection.quadrangles;
+			detections[i].ids = detection.ids;
+			detections[i].poses = detection.poses;
+			detections[i].border = detection.border;
+			detections[i].scale = detection.scale;
+			detections[i].quadStats = detection.quadStats;
+		},
+		[&](int i)
+		{
+			// Outputs are written in input order, the writer thread encodes the overlays
+			results.write(i, files[i], 0, detections[i]);
+			quadStats.merge(detections[i].quadStats);
+			decodeTotal.merge(decodeStats[i]);
+			profileSummary.add(profiles[i]);
+			trace.add(profiles[i]);
+			profiles[i] = FrameProfile();
+			if(overlays[i].width>0)
+				writer.write(pngOutputPath(fileStem(files[i])), std::move(overlays[i]));
+			detections[i] = Detection();
+			overlays[i] = Image();
+		});
+	writer.flush();
+	results.close();
+	trace.close();
+	printBatchStats(stats);
+	printQuadStats(quadStats);
+	if(options.decode)
+		printDecodeStats(decodeTotal);
+	profileSummary.print();
+
+	return 0;
 }
 
+int detectStream(const Options& options, ResultWriter& results, TraceWriter& trace)
+{
+	FrameSource source;
+	if(!source.open(options.stream, options.streamFormat, options.streamWidth, options.streamHeight))
+		return 1;
+
+	// Frames are detected one at a time with all the threads, the next one is read meanwhile
+	PngWriter writer(options.compression);
+	Detector detector(options.pyramidLevels, hardwareThreads(), options.engine);
+	TagTracker tracker(options.fullScanEvery, options.pyramidLevels, options.engine);
+	int fullScans = 0;
+	QuadStats quadStats;
+	DecodeStats decodeStats;
+	FrameProfile profile;
+	ProfileSummary profileSummary;
+	BatchStats stats = runStream(source, 2, [&](int i, ConstImageView frame, double timestamp)
+	{
+		// The previous frame is complete once the next one starts
+		if(profile.frame>=0)
+		{
+			profileSummary.add(profile);
+			trace.add(profile);
+		}
+		profile.reset();
+		ProfileFrame profileFrame(profile, i);
+		PROFILE_SCOPE("frame");
+		bool render = options.renderEvery>0 && i%options.renderEvery==0;
+		bool tracking = options.fullScanEvery>0;
+		Detection& detection = tracking ? tracker.update(frame, hardwareThreads(), render) : detector.detect(frame);
+		FrameArena& arena = tracking ? tracker.arena() : detector.arena();
+		if(tracking)
+			fullScans += tracker.wasFullScan();
+		if(options.decode)
+			decodeStats.merge(decodeTags(frame, detection, arena));
+		if(options.camera.valid())
+			estimatePoses(detection, options.camera, options.tagSize);
+		results.write(i, options.stream, timestamp, detection);
+		quadStats.merge(detection.quadStats);
+		if(render)
+		{
+			char name[32];
+			snprintf(name, sizeof(name), "frame%06d", i);
+			writer.write(pngOutputPath(name), renderDetection(detection, hardwareThreads()));
+		}
+	});
+	if(profile.frame>=0)
+	{
+		profileSummary.add(profile);
+		trace.add(profile);
+	}
+	writer.flush();
+	results.close();
+	trace.close();
+	printBatchStats(stats);
+	printQuadStats(quadStats);
+	if(options.decode)
+		printDecodeStats(decodeStats);
+	if(options.fullScanEvery>0)
+		std::cerr << "Full frame scans: " << fullScans << "/" << stats.frames << std::endl;
+	profileSummary.print();
+
+	return 0;
+}
@@ -0,0 +1,362 @@
+//--------------------------------------------------
+// Robot Simulator
+// png.hpp
+// Date: 17/10/2026
+// By Breno Cunha Queiroz
+//--------------------------------------------------
+#ifndef PNG_H
+#define PNG_H
+#include <vector>
+#include <deque>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <algorithm>
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+#if defined(ARTAG_HAVE_ZLIB)
+#include <zlib.h>
+#endif
+#include "helpers.hpp"
+
+//--------------------//
+//---- Checksums -----//
+//--------------------//
+// Slice-by-8 tables: crcTables()[k][b] is the CRC of byte b followed by k zero bytes
+const std::vector<uint32_t>& crcTables()
+{
+	static const std::vector<uint32_t> tables = []()
+	{
+		std::vector<uint32_t> t(8*256);
+		for(uint32_t i=0;i<256;i++)
+		{
+			uint32_t c = i;
+			for(int k=0;k<8;k++)
+				c = c&1 ? 0xedb88320u^(c>>1) : c>>1;
+			t[i] = c;
+		}
+		for(int i=0;i<256;i++)
+			for(int k=1;k<8;k++)
+				t[k*256+i] = (t[(k-1)*256+i]>>8) ^ t[t[(k-1)*256+i]&0xff];
+		return t;
+	}();
+	return tables;
+}
+
+// Running CRC32, start with crc=0
+uint32_t crc32(uint32_t crc, const unsigned char* data, size_t n)
+{
+	const uint32_t* t = crcTables().data();
+	crc = ~crc;
+	for(;n>=8;n-=8,data+=8)
+	{
+		uint32_t lo, hi;
+		std::memcpy(&lo, data, 4);
+		std::memcpy(&hi, data+4, 4);
+		lo ^= crc;// Little endian
+		crc = t[7*256 + (lo&0xff)] ^ t[6*256 + ((lo>>8)&0xff)] ^ t[5*256 + ((lo>>16)&0xff)] ^ t[4*256 + (lo>>24)] ^
+			t[3*256 + (hi&0xff)] ^ t[2*256 + ((hi>>8)&0xff)] ^ t[1*256 + ((hi>>16)&0xff)] ^ t[hi>>24];
+	}
+	for(;n>0;n--)
+		crc = t[(crc^*data++)&0xff] ^ (crc>>8);
+	return ~crc;
+}
+
+// Running Adler-32, start with adler=1
+uint32_t adler32(uint32_t adler, const unsigned char* data, size_t n)
+{
+	static constexpr uint32_t BASE = 65521;
+	static constexpr size_t NMAX = 5552;// Largest block that can not overflow b
+	uint32_t a = adler&0xffff;
+	uint32_t b = adler>>16;
+	while(n>0)
+	{
+		size_t block = std::min(n, NMAX);
+		n -= block;
+#if defined(__SSE2__)
+		// 16 bytes per step: a += sum(v[i]), b += 16*a + sum((16-i)*v[i])
+		size_t vec = block&~size_t(15);
+		if(vec>0)
+		{
+			const __m128i zero = _mm_setzero_si128();
+			const __m128i weightsLo = _mm_setr_epi16(16, 15, 14, 13, 12, 11, 10, 9);
+			const __m128i weightsHi = _mm_setr_epi16(8, 7, 6, 5, 4, 3, 2, 1);
+			__m128i sumA = _mm_setzero_si128();
+			__m128i sumB = _mm_setzero_si128();
+			__m128i prevA = _mm_setzero_si128();// Sum of a before each step
+			for(size_t i=0;i<vec;i+=16)
+			{
+				__m128i v = _mm_loadu_si128((const __m128i*)(data+i));
+				prevA = _mm_add_epi32(prevA, sumA);
+				sumA = _mm_add_epi32(sumA, _mm_sad_epu8(v, zero));
+				sumB = _mm_add_epi32(sumB, _mm_madd_epi16(_mm_unpacklo_epi8(v, zero), weightsLo));
+				sumB = _mm_add_epi32(sumB, _mm_madd_epi16(_mm_unpackhi_epi8(v, zero), weightsHi));
+			}
+			uint32_t lanesA[4], lanesB[4], lanesPrev[4];
+			_mm_storeu_si128((__m128i*)lanesA, sumA);
+			_mm_storeu_si128((__m128i*)lanesB, sumB);
+			_mm_storeu_si128((__m128i*)lanesPrev, prevA);
+			b += a*uint32_t(vec) + 16*(lanesPrev[0]+lanesPrev[2]) + lanesB[0]+lanesB[1]+lanesB[2]+lanesB[3];
+			a += lanesA[0]+lanesA[2];
+			data += vec;
+			block -= vec;
+		}
+#endif
+		for(;block>0;block--)
+		{
+			a += *data++;
+			b += a;
+		}
+		a %= BASE;
+		b %= BASE;
+	}
+	return (b<<16) | a;
+}
+
+//--------------------//
+//------ Encode ------//
+//--------------------//
+void putBigEndian(std::vector<unsigned char>& out, uint32_t value)
+{
+	out.push_back(value>>24);
+	out.push_back(value>>16);
+	out.push_back(value>>8);
+	out.push_back(value);
+}
+
+// Chunk length, type and CRC around data already appended after start
+void finishChunk(std::vector<unsigned char>& out, size_t start)
+{
+	uint32_t length = out.size()-start-8;
+	for(int k=0;k<4;k++)
+		out[start+k] = length>>(24-8*k);
+	putBigEndian(out, crc32(0, &out[start+4], out.size()-start-4));
+}
+
+void beginChunk(std::vector<unsigned char>& out, const char* type)
+{
+	out.insert(out.end(), 4, 0);
+	out.insert(out.end(), type, type+4);
+}
+
+// Encode 1 (gray), 3 (RGB) or 4 (RGBA) channel images. Compression 0 writes stored
+// deflate blocks (fastest), 1-9 are zlib levels when built with zlib.
+bool encodePng(ConstImageView image, std::vector<unsigned char>& out, int compression=0)
+{
+	int colorType;
+	switch(image.channels)
+	{
+		case 1: colorType = 0; break;
+		case 3: colorType = 2; break;
+		case 4: colorType = 6; break;
+		default:
+			std::cout << "[encodePng] Unsupported channel count. Nothing done" << std::endl;
+			return false;
+	}
+
+	size_t rowSize = size_t(image.width)*image.channels;
+	size_t rawSize = (rowSize+1)*image.height;// Filter byte (none) per row
+	out.clear();
+	out.reserve(rawSize + rawSize/65535*5 + 128);
+
+	static const unsigned char signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+	out.insert(out.end(), signature, signature+8);
+
+	size_t start = out.size();
+	beginChunk(out, "IHDR");
+	putBigEndian(out, image.width);
+	putBigEndian(out, image.height);
+	out.push_back(8);// Bit depth
+	out.push_back(colorType);
+	out.push_back(0);// Deflate
+	out.push_back(0);// Adaptive filtering
+	out.push_back(0);// No interlace
+	finishChunk(out, start);
+
+	start = out.size();
+	beginChunk(out, "IDAT");
+#if defined(ARTAG_HAVE_ZLIB)
+	if(compression>0)
+	{
+		std::vector<unsigned char> raw(rawSize);
+		for(int y=0;y<(int)image.height;y++)
+			std::copy(image.row(y), image.row(y)+rowSize, &raw[y*(rowSize+1)+1]);
+		uLongf size = compressBound(rawSize);
+		out.resize(out.size()+size);
+		if(compress2(&out[start+8], &size, raw.data(), rawSize, std::min(compression, 9))!=Z_OK)
+			return false;
+		out.resize(start+8+size);
+		compression = -1;
+	}
+#endif
+	if(compression>=0)
+	{
+		// zlib stream of stored blocks, rows are copied straight into the blocks
+		static constexpr size_t MAX_BLOCK = 65535;
+		out.push_back(0x78);
+		out.push_back(0x01);
+		uint32_t adler = 1;
+		size_t blockLeft = 0;
+		size_t remaining = rawSize;
+		auto append = [&](const unsigned char* data, size_t n)
+		{
+			adler = adler32(adler, data, n);
+			while(n>0)
+			{
+				if(blockLeft==0)
+				{
+					blockLeft = std::min(remaining, MAX_BLOCK);
+					remaining -= blockLeft;
+					out.push_back(remaining==0 ? 1 : 0);
+					out.push_back(blockLeft&0xff);
+					out.push_back(blockLeft>>8);
+					out.push_back(~blockLeft&0xff);
+					out.push_back((~blockLeft>>8)&0xff);
+				}
+				size_t count = std::min(n, blockLeft);
+				out.insert(out.end(), data, data+count);
+				data += count;
+				n -= count;
+				blockLeft -= count;
+			}
+		};
+		const unsigned char filter = 0;
+		for(int y=0;y<(int)image.height;y++)
+		{
+			append(&filter, 1);
+			append(image.row(y), rowSize);
+		}
+		putBigEndian(out, adler);
+	}
+	finishChunk(out, start);
+
+	start = out.size();
+	beginChunk(out, "IEND");
+	finishChunk(out, start);
+	return true;
+}
+
+//--------------------//
+//------ Write -------//
+//--------------------//
+// Directory used by writePng(fileName, ...), with a trailing separator
+std::string& pngOutputDirectory()
+{
+	static std::string directory = "../../output/";
+	return directory;
+}
+
+void setPngOutputDirectory(std::string directory)
+{
+	if(!directory.empty() && directory.back()!='/')
+		directory += '/';
+	pngOutputDirectory() = directory;
+}
+
+std::string pngOutputPath(const std::string& fileName)
+{
+	return pngOutputDirectory()+fileName+".png";
+}
+
+void writePngFile(std::string path, ConstImageView image, int compression=0)
+{
+	std::vector<unsigned char> png;
+	if(!encodePng(image, png, compression))
+		return;
+
+	FILE* fp = fopen(path.c_str(), "wb");
+	if(fp==nullptr)
+	{
+		std::cout << "[writePng] Could not open " << path << std::endl;
+		return;
+	}
+	fwrite(png.data(), 1, png.size(), fp);
+	fclose(fp);
+}
+
+void writePng(std::string fileName, ConstImageView image, int compression=0)
+{
+	writePngFile(pngOutputPath(fileName), image, compression);
+}
+
+void writePng(std::string fileName, const Image& image, int compression=0)
+{
+	writePng(fileName, image.view(), compression);
+}
+
+// Encodes and writes images on a background thread. At most maxPending images
+// are queued, write() only waits when the disk can not keep up with that.
+class PngWriter
+{
+public:
+	PngWriter(int compression=0, int maxPending=8):
+		compression(compression), maxPending(std::max(1, maxPending))
+	{
+		worker = std::thread([this]()
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			while(true)
+			{
+				changed.wait(lock, [this]() { return stop || !pending.empty(); });
+				if(pending.empty())
+					return;
+				busy = true;
+				std::pair<std::string, Image> job = std::move(pending.front());
+				pending.pop_front();
+				changed.notify_all();
+				lock.unlock();
+				writePngFile(job.first, job.second.view(), this->compression);
+				lock.lock();
+				busy = false;
+				changed.notify_all();
+			}
+		});
+	}
+
+	~PngWriter()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stop = true;
+		}
+		changed.notify_all();
+		worker.join();
+	}
+
+	PngWriter(const PngWriter&) = delete;
+	PngWriter& operator=(const PngWriter&) = delete;
+
+	// Takes the image, the caller does not need to keep it
+	void write(std::string path, Image image)
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		changed.wait(lock, [this]() { return (int)pending.size()<maxPending; });
+		pending.emplace_back(std::move(path), std::move(image));
+		changed.notify_all();
+	}
+
+	// Wait until every queued image is on disk
+	void flush()
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		changed.wait(lock, [this]() { return pending.empty() && !busy; });
+	}
+
+private:
+	int compression;
+	int maxPending;
+	std::deque<std::pair<std::string, Image>> pending;
+	bool busy = false;
+	bool stop = false;
+	std::mutex mutex;
+	std::condition_variable changed;
+	std::thread worker;
+};
+
+#endif// PNG_H
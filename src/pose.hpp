@@ -0,0 +1,249 @@
+//--------------------------------------------------
+// Robot Simulator
+// pose.hpp
+// Date: 17/10/2026
+// By Breno Cunha Queiroz
+//--------------------------------------------------
+#ifndef POSE_H
+#define POSE_H
+#include <cmath>
+#include <algorithm>
+#include "helpers.hpp"
+#include "homography.hpp"
+
+// Pinhole camera, pixels
+struct CameraIntrinsics
+{
+	double fx = 0;
+	double fy = 0;
+	double cx = 0;
+	double cy = 0;
+
+	bool valid() const { return fx>0 && fy>0; }
+};
+
+// Tag frame: origin at the tag center, x towards p1, y towards p3, z into the
+// tag (away from the camera). Camera frame: x right, y down, z forward.
+struct TagPose
+{
+	float rotation[9] = {1, 0, 0, 0, 1, 0, 0, 0, 1};// Row major, tag to camera
+	float translation[3] = {0, 0, 0};// Tag center in the camera frame, tag size units
+	float error = -1;// RMS reprojection error in pixels, -1 if not estimated
+};
+
+#define POSE_BATCH_SIZE 64
+
+// All the tags of a frame as a struct of arrays, one column per tag. Nothing
+// is allocated, a frame with more tags is processed in several batches.
+struct PoseBatch
+{
+	int count = 0;
+	// Input: corner k of each tag in pixels, in the order of the tag frame
+	float u[4][POSE_BATCH_SIZE];
+	float v[4][POSE_BATCH_SIZE];
+	// Output
+	double R[9][POSE_BATCH_SIZE];
+	double t[3][POSE_BATCH_SIZE];
+	float error[POSE_BATCH_SIZE];
+	bool valid[POSE_BATCH_SIZE];
+};
+
+//--------------------//
+//------ Stages ------//
+//--------------------//
+// Initial pose from the homography between the tag plane and the normalized
+// image plane, H ~ [r1 r2 t]. The rotation is the closest orthonormal matrix.
+bool poseFromHomography(const Homography& homography, double R[9], double t[3])
+{
+	const double* h = homography.h;
+	double norm1 = std::sqrt(h[0]*h[0] + h[3]*h[3] + h[6]*h[6]);
+	double norm2 = std::sqrt(h[1]*h[1] + h[4]*h[4] + h[7]*h[7]);
+	double scale = 2/(norm1+norm2);
+	if(!std::isfinite(scale))
+		return false;
+	// The tag is in front of the camera
+	if(h[8]*scale<0)
+		scale = -scale;
+
+	double r1[3] = {h[0]*scale, h[3]*scale, h[6]*scale};
+	double r2[3] = {h[1]*scale, h[4]*scale, h[7]*scale};
+	t[0] = h[2]*scale;
+	t[1] = h[5]*scale;
+	t[2] = h[8]*scale;
+
+	// Symmetric orthogonalization of r1 and r2, then r3 = r1 x r2
+	for(int k=0;k<3;k++)
+	{
+		r1[k] *= (norm1+norm2)/(2*norm1);
+		r2[k] *= (norm1+norm2)/(2*norm2);
+	}
+	double c[3] = {r1[0]+r2[0], r1[1]+r2[1], r1[2]+r2[2]};
+	double d[3] = {r1[0]-r2[0], r1[1]-r2[1], r1[2]-r2[2]};
+	double cNorm = std::sqrt(c[0]*c[0] + c[1]*c[1] + c[2]*c[2]);
+	double dNorm = std::sqrt(d[0]*d[0] + d[1]*d[1] + d[2]*d[2]);
+	if(cNorm<1e-12 || dNorm<1e-12)
+		return false;
+	for(int k=0;k<3;k++)
+	{
+		r1[k] = (c[k]/cNorm + d[k]/dNorm)/std::sqrt(2.0);
+		r2[k] = (c[k]/cNorm - d[k]/dNorm)/std::sqrt(2.0);
+	}
+	double r3[3] = {r1[1]*r2[2]-r1[2]*r2[1], r1[2]*r2[0]-r1[0]*r2[2], r1[0]*r2[1]-r1[1]*r2[0]};
+	for(int row=0;row<3;row++)
+	{
+		R[row*3] = r1[row];
+		R[row*3+1] = r2[row];
+		R[row*3+2] = r3[row];
+	}
+	return true;
+}
+
+// Gauss-Newton on the reprojection error of the four corners, the rotation is
+// updated by R = exp([w]x) R. Returns the RMS error in pixels.
+double refinePose(const Point object[4], const double u[4], const double v[4], const CameraIntrinsics& camera,
+		double R[9], double t[3], int iterations)
+{
+	double rms = 0;
+	for(int iteration=0;iteration<=iterations;iteration++)
+	{
+		double JtJ[6][6] = {};
+		double Jtr[6] = {};
+		double squared = 0;
+		for(int k=0;k<4;k++)
+		{
+			double X = object[k].x, Y = object[k].y;
+			double q[3] = {R[0]*X + R[1]*Y, R[3]*X + R[4]*Y, R[6]*X + R[7]*Y};// R X
+			double P[3] = {q[0]+t[0], q[1]+t[1], q[2]+t[2]};
+			if(P[2]<=0)
+				return INFINITY;
+			double iz = 1/P[2];
+			double x = P[0]*iz, y = P[1]*iz;
+			double residual[2] = {camera.fx*x + camera.cx - u[k], camera.fy*y + camera.cy - v[k]};
+			squared += residual[0]*residual[0] + residual[1]*residual[1];
+			if(iteration==iterations)
+				continue;
+
+			// a = d(pixel)/dP, dP/dw = -[q]x gives q x a, dP/dt = I
+			double dP[2][3] = {{camera.fx*iz, 0, -camera.fx*x*iz}, {0, camera.fy*iz, -camera.fy*y*iz}};
+			for(int r=0;r<2;r++)
+			{
+				const double* a = dP[r];
+				double J[6] = {
+					q[1]*a[2] - q[2]*a[1],
+					q[2]*a[0] - q[0]*a[2],
+					q[0]*a[1] - q[1]*a[0],
+					a[0], a[1], a[2]};
+				for(int i=0;i<6;i++)
+				{
+					Jtr[i] += J[i]*residual[r];
+					for(int j=0;j<6;j++)
+						JtJ[i][j] += J[i]*J[j];
+				}
+			}
+		}
+		rms = std::sqrt(squared/4);
+		if(iteration==iterations)
+			break;
+
+		double b[6];
+		for(int i=0;i<6;i++)
+			b[i] = -Jtr[i];
+		double delta[6];
+		if(!solveLinear<6>(JtJ, b, delta))
+			break;
+
+		// Rodrigues
+		double angle = std::sqrt(delta[0]*delta[0] + delta[1]*delta[1] + delta[2]*delta[2]);
+		double dR[9] = {1, 0, 0, 0, 1, 0, 0, 0, 1};
+		if(angle>1e-12)
+		{
+			double k[3] = {delta[0]/angle, delta[1]/angle, delta[2]/angle};
+			double s = std::sin(angle), c = 1-std::cos(angle);
+			dR[0] = 1 - c*(k[1]*k[1] + k[2]*k[2]);
+			dR[1] = -s*k[2] + c*k[0]*k[1];
+			dR[2] = s*k[1] + c*k[0]*k[2];
+			dR[3] = s*k[2] + c*k[0]*k[1];
+			dR[4] = 1 - c*(k[0]*k[0] + k[2]*k[2]);
+			dR[5] = -s*k[0] + c*k[1]*k[2];
+			dR[6] = -s*k[1] + c*k[0]*k[2];
+			dR[7] = s*k[0] + c*k[1]*k[2];
+			dR[8] = 1 - c*(k[0]*k[0] + k[1]*k[1]);
+		}
+		double updated[9];
+		for(int row=0;row<3;row++)
+			for(int col=0;col<3;col++)
+				updated[row*3+col] = dR[row*3]*R[col] + dR[row*3+1]*R[3+col] + dR[row*3+2]*R[6+col];
+		std::copy(updated, updated+9, R);
+		for(int i=0;i<3;i++)
+			t[i] += delta[3+i];
+	}
+	return rms;
+}
+
+// Pose of every tag of the batch. tagSize is the side of the black border,
+// the translations come out in the same unit.
+void estimatePoses(PoseBatch& batch, const CameraIntrinsics& camera, double tagSize, int iterations=5)
+{
+	double half = tagSize/2;
+	const Point object[4] = {{float(-half), float(-half)}, {float(half), float(-half)}, {float(half), float(half)}, {float(-half), float(half)}};
+	for(int i=0;i<batch.count;i++)
+	{
+		double u[4], v[4];
+		Point normalized[4];
+		for(int k=0;k<4;k++)
+		{
+			u[k] = batch.u[k][i];
+			v[k] = batch.v[k][i];
+			normalized[k] = {float((u[k]-camera.cx)/camera.fx), float((v[k]-camera.cy)/camera.fy)};
+		}
+
+		double R[9], t[3];
+		Homography H;
+		batch.valid[i] = computeHomography(object, normalized, H) && poseFromHomography(H, R, t);
+		if(batch.valid[i])
+		{
+			double rms = refinePose(object, u, v, camera, R, t, iterations);
+			batch.valid[i] = std::isfinite(rms);
+			batch.error[i] = rms;
+		}
+		for(int k=0;k<9;k++)
+			batch.R[k][i] = batch.valid[i] ? R[k] : 0;
+		for(int k=0;k<3;k++)
+			batch.t[k][i] = batch.valid[i] ? t[k] : 0;
+		if(!batch.valid[i])
+			batch.error[i] = -1;
+	}
+}
+
+// Poses of quadrangles (corners in the tag frame order, see decodeTags), written to poses
+void estimatePoses(const Quadrangle* quadrangles, int count, const CameraIntrinsics& camera, double tagSize,
+		TagPose* poses, int iterations=5)
+{
+	PoseBatch batch;
+	for(int first=0;first<count;first+=POSE_BATCH_SIZE)
+	{
+		batch.count = std::min(count-first, POSE_BATCH_SIZE);
+		for(int i=0;i<batch.count;i++)
+		{
+			const Quadrangle& quad = quadrangles[first+i];
+			const Point corners[4] = {quad.p0, quad.p1, quad.p2, quad.p3};
+			for(int k=0;k<4;k++)
+			{
+				batch.u[k][i] = corners[k].x;
+				batch.v[k][i] = corners[k].y;
+			}
+		}
+		estimatePoses(batch, camera, tagSize, iterations);
+		for(int i=0;i<batch.count;i++)
+		{
+			TagPose& pose = poses[first+i];
+			for(int k=0;k<9;k++)
+				pose.rotation[k] = batch.R[k][i];
+			for(int k=0;k<3;k++)
+				pose.translation[k] = batch.t[k][i];
+			pose.error = batch.error[i];
+		}
+	}
+}
+
+#endif// POSE_H
@@ -0,0 +1,102 @@
+//--------------------------------------------------
+// Robot Simulator
+// preprocess.hpp
+// Date: 17/10/2026
+// By Breno Cunha Queiroz
+//--------------------------------------------------
+#ifndef PREPROCESS_H
+#define PREPROCESS_H
+#include <vector>
+#include <iostream>
+#include "helpers.hpp"
+#include "imgProc.hpp"
+#include "arena.hpp"
+
+// Rows [y0,y1) of computeEdgelsFused(), TAPS as in blurColumn(). Bands restart
+// their rings: the first blurred row of a band (except the top one) is only
+// computed as the halo of the gradient.
+template<int TAPS=0>
+void computeEdgelsFusedRows(ConstImageView image, ImageView result, const SeparableKernel& kernel, int thresh,
+		FrameArena& arena, int y0, int y1)
+{
+	int taps = TAPS>0 ? TAPS : 2*kernel.radius+1;
+	int width = image.width;
+	int blurWidth = result.width;
+	unsigned char* grayRing = arena.allocate<unsigned char>(taps*width);// Gray row y is in slot y%taps
+	unsigned char* blurRing = arena.allocate<unsigned char>(2*blurWidth);// Blurred row y is in slot y%2
+	uint16_t* columnSums = arena.allocate<uint16_t>(width);
+	const unsigned char** rows = arena.allocate<const unsigned char*>(taps);
+	int16_t* dx = arena.allocate<int16_t>(blurWidth);
+	int16_t* dy = arena.allocate<int16_t>(blurWidth);
+
+	int start = std::max(0, y0-1);
+	int grayRows = start;// Next gray row to compute
+	for(int y=start;y<y1;y++)
+	{
+		// Grayscale
+		for(;grayRows<y+taps;grayRows++)
+			grayscaleMaxRow(image.row(grayRows), width, image.channels, &grayRing[(grayRows%taps)*width]);
+
+		// Blur
+		for(int k=0;k<taps;k++)
+			rows[k] = &grayRing[((y+k)%taps)*width];
+		unsigned char* blurred = &blurRing[(y%2)*blurWidth];
+		blurColumn<TAPS>(rows, kernel.column.data(), taps, width, columnSums);
+		blurRow<TAPS, 1>(columnSums, kernel.row.data(), taps, 1, blurWidth, blurred);
+		if(y<y0)
+			continue;
+
+		// Edgels
+		unsigned char* dst = result.row(y);
+		std::fill(dst, dst+blurWidth, 0);
+		if(y>0)
+		{
+			gradientRow(blurred, &blurRing[((y-1)%2)*blurWidth], blurWidth, dx, dy);
+			edgelRow(dx, dy, blurWidth, thresh, dst);
+		}
+	}
+}
+
+typedef void (*FusedEdgelRows)(ConstImageView, ImageView, const SeparableKernel&, int, FrameArena&, int, int);
+
+// Specialized rows for the 3x3, 5x5 and 7x7 kernels
+FusedEdgelRows fusedEdgelRowsFor(int radius)
+{
+	switch(radius)
+	{
+		case 1: return computeEdgelsFusedRows<3>;
+		case 2: return computeEdgelsFusedRows<5>;
+		case 3: return computeEdgelsFusedRows<7>;
+		default: return computeEdgelsFusedRows<0>;
+	}
+}
+
+// Fused grayscaleMax -> separableConvolution -> computeEdgels.
+// Only the last 2*radius+1 gray rows and the last two blurred rows are kept
+// (ring buffers small enough to stay in cache), the intermediate images are
+// never written. The result is identical to running the three stages.
+// The rings of every band are allocated in the arena.
+void computeEdgelsFused(ConstImageView image, ImageView result, const SeparableKernel& kernel, int thresh, FrameArena& arena, int numThreads=1)
+{
+	int r = kernel.radius;
+	if((int)image.width<=2*r || (int)image.height<=2*r ||
+		result.width!=image.width-r*2 || result.height!=image.height-r*2 || result.channels!=1)
+	{
+		std::cout << "[computeEdgelsFused] Incompatible images. Nothing done" << std::endl;
+		return;
+	}
+
+	FusedEdgelRows rows = fusedEdgelRowsFor(r);
+	parallelRows(result.height, numThreads, [&](int y0, int y1)
+	{
+		rows(image, result, kernel, thresh, arena, y0, y1);
+	});
+}
+
+void computeEdgelsFused(ConstImageView image, ImageView result, const SeparableKernel& kernel, int thresh, int numThreads=1)
+{
+	FrameArena arena;
+	computeEdgelsFused(image, result, kernel, thresh, arena, numThreads);
+}
+
+#endif// PREPROCESS_H
@@ -0,0 +1,283 @@
+//--------------------------------------------------
+// Robot Simulator
+// profiler.hpp
+// Date: 17/10/2026
+// By Breno Cunha Queiroz
+//--------------------------------------------------
+#ifndef PROFILER_H
+#define PROFILER_H
+#include <vector>
+#include <string>
+#include <chrono>
+#include <atomic>
+#include <cstdio>
+#include <cstdint>
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+
+// Scoped timers and counters of the detector. They are recorded in the
+// FrameProfile made active on the calling thread, nothing is recorded when
+// there is none. Without ARTAG_PROFILE the macros expand to nothing.
+#ifdef ARTAG_PROFILE
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(name)
+#define PROFILE_COUNT(counter, n) profileCount(counter, n)
+#else
+#define PROFILE_SCOPE(name)
+#define PROFILE_COUNT(counter, n)
+#endif
+
+enum ProfileCounter
+{
+	PROFILE_EDGELS,
+	PROFILE_REGIONS,
+	PROFILE_SMALL_REGIONS,// Under 20 edgels, no line is fitted
+	PROFILE_LINES,
+	PROFILE_GRAPH_EDGES,
+	PROFILE_CYCLES,// Closed 4-cycles, before the quadrangle stages
+	PROFILE_CONTOURS,// Borders traced by the contour engine
+	PROFILE_QUADS,
+	PROFILE_COUNTERS
+};
+
+const char* profileCounterName(int counter)
+{
+	static const char* names[PROFILE_COUNTERS] = {"edgels", "regions", "smallRegions", "lines", "graphEdges", "cycles", "contours", "quads"};
+	return names[counter];
+}
+
+struct ProfileEvent
+{
+	const char* name;// String literal
+	int64_t start;// Nanoseconds since profileClock() started
+	int64_t duration;
+	int thread;
+};
+
+struct FrameProfile
+{
+	int frame = -1;
+	std::vector<ProfileEvent> events;
+	long counters[PROFILE_COUNTERS] = {};
+
+	// Keeps the event storage for the next frame
+	void reset()
+	{
+		frame = -1;
+		events.clear();
+		std::fill(counters, counters+PROFILE_COUNTERS, 0);
+	}
+};
+
+int64_t profileClock()
+{
+	typedef std::chrono::steady_clock Clock;
+	static const Clock::time_point epoch = Clock::now();
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now()-epoch).count();
+}
+
+// Small sequential id of the calling thread
+int profileThread()
+{
+	static std::atomic<int> next(0);
+	static thread_local int id = next++;
+	return id;
+}
+
+FrameProfile*& activeProfile()
+{
+	static thread_local FrameProfile* profile = nullptr;
+	return profile;
+}
+
+void profileCount(ProfileCounter counter, long n)
+{
+	if(activeProfile()!=nullptr)
+		activeProfile()->counters[counter] += n;
+}
+
+// Makes profile active on this thread until destroyed
+class ProfileFrame
+{
+public:
+	ProfileFrame(FrameProfile& profile, int frame): previous(activeProfile())
+	{
+		profile.frame = frame;
+		activeProfile() = &profile;
+	}
+	~ProfileFrame() { activeProfile() = previous; }
+	ProfileFrame(const ProfileFrame&) = delete;
+	ProfileFrame& operator=(const ProfileFrame&) = delete;
+
+private:
+	FrameProfile* previous;
+};
+
+class ProfileScope
+{
+public:
+	explicit ProfileScope(const char* name): profile(activeProfile()), name(name)
+	{
+		if(profile!=nullptr)
+			start = profileClock();
+	}
+	~ProfileScope()
+	{
+		if(profile!=nullptr)
+			profile->events.push_back({name, start, profileClock()-start, profileThread()});
+	}
+	ProfileScope(const ProfileScope&) = delete;
+	ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+	FrameProfile* profile;
+	const char* name;
+	int64_t start = 0;
+};
+
+bool profilingEnabled()
+{
+#ifdef ARTAG_PROFILE
+	return true;
+#else
+	return false;
+#endif
+}
+
+//--------------------//
+//------ Output ------//
+//--------------------//
+// Chrome trace-event JSON (chrome://tracing, Perfetto), written as frames are
+// added: one complete event per scope (args.frame is its frame) and one counter
+// event per frame
+class TraceWriter
+{
+public:
+	TraceWriter() = default;
+	TraceWriter(const TraceWriter&) = delete;
+	TraceWriter& operator=(const TraceWriter&) = delete;
+	~TraceWriter() { close(); }
+
+	bool open(const std::string& path)
+	{
+		close();
+		file = fopen(path.c_str(), "w");
+		if(file==nullptr)
+		{
+			std::cout << "[TraceWriter] Could not open " << path << std::endl;
+			return false;
+		}
+		fprintf(file, "{\"traceEvents\":[");
+		first = true;
+		return true;
+	}
+
+	void add(const FrameProfile& profile)
+	{
+		if(file==nullptr || profile.events.empty())
+			return;
+		int64_t frameStart = profile.events.front().start;
+		for(const auto& event : profile.events)
+		{
+			frameStart = std::min(frameStart, event.start);
+			fprintf(file, "%s\n{\"name\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%d,\"args\":{\"frame\":%d}}",
+				first ? "" : ",", event.name, event.start/1000.0, event.duration/1000.0, event.thread, profile.frame);
+			first = false;
+		}
+		fprintf(file, ",\n{\"name\":\"counters\",\"ph\":\"C\",\"ts\":%.3f,\"pid\":1,\"args\":{", frameStart/1000.0);
+		for(int c=0;c<PROFILE_COUNTERS;c++)
+			fprintf(file, "%s\"%s\":%ld", c>0 ? "," : "", profileCounterName(c), profile.counters[c]);
+		fprintf(file, "}}");
+	}
+
+	void close()
+	{
+		if(file==nullptr)
+			return;
+		fprintf(file, "\n]}\n");
+		fclose(file);
+		file = nullptr;
+	}
+
+private:
+	FILE* file = nullptr;
+	bool first = true;
+};
+
+// Per scope name: calls, mean and worst time (with its frame). Per counter:
+// mean over the frames and worst frame.
+class ProfileSummary
+{
+public:
+	void add(const FrameProfile& profile)
+	{
+		frames++;
+		for(const auto& event : profile.events)
+		{
+			auto row = std::find_if(rows.begin(), rows.end(), [&](const Row& r) { return r.name==event.name; });
+			if(row==rows.end())
+			{
+				rows.push_back(Row());
+				row = rows.end()-1;
+				row->name = event.name;
+			}
+			double milliseconds = event.duration/1e6;
+			row->calls++;
+			row->total += milliseconds;
+			if(milliseconds>row->worst)
+			{
+				row->worst = milliseconds;
+				row->worstFrame = profile.frame;
+			}
+		}
+		for(int c=0;c<PROFILE_COUNTERS;c++)
+		{
+			counterTotal[c] += profile.counters[c];
+			if(profile.counters[c]>counterWorst[c])
+			{
+				counterWorst[c] = profile.counters[c];
+				counterWorstFrame[c] = profile.frame;
+			}
+		}
+	}
+
+	void print() const
+	{
+		if(rows.empty())
+			return;
+		std::streamsize precision = std::cerr.precision();
+		std::cerr << std::fixed << std::setprecision(3);
+		std::cerr << std::left << std::setw(20) << "scope" << std::right << std::setw(8) << "calls"
+			<< std::setw(12) << "mean ms" << std::setw(12) << "max ms" << std::setw(10) << "frame" << std::endl;
+		for(const auto& row : rows)
+			std::cerr << std::left << std::setw(20) << row.name << std::right << std::setw(8) << row.calls
+				<< std::setw(12) << row.total/row.calls << std::setw(12) << row.worst << std::setw(10) << row.worstFrame << std::endl;
+
+		std::cerr << std::left << std::setw(20) << "counter" << std::right << std::setw(8) << "frames"
+			<< std::setw(12) << "mean" << std::setw(12) << "max" << std::setw(10) << "frame" << std::endl;
+		for(int c=0;c<PROFILE_COUNTERS;c++)
+			std::cerr << std::left << std::setw(20) << profileCounterName(c) << std::right << std::setw(8) << frames
+				<< std::setw(12) << double(counterTotal[c])/frames << std::setw(12) << counterWorst[c]
+				<< std::setw(10) << counterWorstFrame[c] << std::endl;
+		std::cerr << std::defaultfloat << std::setprecision(precision);
+	}
+
+private:
+	struct Row
+	{
+		std::string name;
+		long calls = 0;
+		double total = 0;// Milliseconds
+		double worst = 0;
+		int worstFrame = -1;
+	};
+	std::vector<Row> rows;
+	long frames = 0;
+	long counterTotal[PROFILE_COUNTERS] = {};
+	long counterWorst[PROFILE_COUNTERS] = {};
+	int counterWorstFrame[PROFILE_COUNTERS] = {-1, -1, -1, -1, -1, -1, -1, -1};
+};
+
+#endif// PROFILER_H
@@ -0,0 +1,255 @@
+//--------------------------------------------------
+// Robot Simulator
+// pyramid.hpp
+// Date: 17/10/2026
+// By Breno Cunha Queiroz
+//--------------------------------------------------
+#ifndef PYRAMID_H
+#define PYRAMID_H
+#include <vector>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <algorithm>
+#include "helpers.hpp"
+#include "threadPool.hpp"
+#include "imgProc.hpp"
+#include "arena.hpp"
+
+//--------------------//
+//---- Decimation ----//
+//--------------------//
+// 2x decimation of a gray image with the separable [1 3 3 1]/8 antialiasing filter.
+// Output pixel x is centered on input x=2x+0.5, borders are clamped.
+void pyramidDown(ConstImageView image, ImageView result, FrameArena& arena, int numThreads=1)
+{
+	if(image.channels!=1 || result.channels!=1 || result.width!=image.width/2 || result.height!=image.height/2 || result.width==0 || result.height==0)
+	{
+		std::cout << "[pyramidDown] Incompatible images. Nothing done" << std::endl;
+		return;
+	}
+
+	int width = image.width;
+	int lastRow = image.height-1;
+	parallelRows(result.height, numThreads, [&](int y0, int y1)
+	{
+		uint16_t* column = arena.allocate<uint16_t>(width+2);// Clamped border at both ends
+		for(int y=y0;y<y1;y++)
+		{
+			const unsigned char* r0 = image.row(std::max(0, 2*y-1));
+			const unsigned char* r1 = image.row(2*y);
+			const unsigned char* r2 = image.row(std::min(lastRow, 2*y+1));
+			const unsigned char* r3 = image.row(std::min(lastRow, 2*y+2));
+			uint16_t* sums = column+1;
+			for(int x=0;x<width;x++)
+				sums[x] = r0[x] + 3*(r1[x]+r2[x]) + r3[x];
+			sums[-1] = sums[0];
+			sums[width] = sums[width-1];
+
+			unsigned char* dst = result.row(y);
+			for(int x=0;x<(int)result.width;x++)
+			{
+				int i = 2*x;
+				dst[x] = (sums[i-1] + 3*(sums[i]+sums[i+1]) + sums[i+2] + 32)>>6;
+			}
+		}
+	});
+}
+
+void pyramidDown(ConstImageView image, ImageView result, int numThreads=1)
+{
+	FrameArena arena;
+	pyramidDown(image, result, arena, numThreads);
+}
+
+// Level 0 is the gray input, level i is decimated 2^i times. The previous
+// levels go back to the pool and the new ones come from it.
+void buildPyramid(ConstImageView image, int levels, std::vector<Image>& pyramid, ImagePool& images, FrameArena& arena, int numThreads=1)
+{
+	for(auto& level : pyramid)
+		images.release(std::move(level));
+	pyramid.clear();
+
+	Image gray = images.acquire(image.width, image.height, 1);
+	grayscaleMax(image, gray.view(), numThreads);
+	pyramid.push_back(std::move(gray));
+	for(int i=1;i<=levels;i++)
+	{
+		const Image& fine = pyramid.back();
+		if(fine.width<2 || fine.height<2)
+			break;
+		Image coarse = images.acquire(fine.width/2, fine.height/2, 1);
+		pyramidDown(fine.view(), coarse.view(), arena, numThreads);
+		pyramid.push_back(std::move(coarse));
+	}
+}
+
+std::vector<Image> buildPyramid(ConstImageView image, int levels, int numThreads=1)
+{
+	FrameArena arena;
+	ImagePool images;
+	std::vector<Image> pyramid;
+	buildPyramid(image, levels, pyramid, images, arena, numThreads);
+	return pyramid;
+}
+
+// Coarse level pixel centers back to input coordinates
+Point pyramidToInput(Point p, int scale)
+{
+	return {(p.x+0.5f)*scale-0.5f, (p.y+0.5f)*scale-0.5f};
+}
+
+//--------------------//
+//---- Refinement ----//
+//--------------------//
+bool sampleBilinear(ConstImageView gray, float x, float y, float& value)
+{
+	int x0 = (int)std::floor(x);
+	int y0 = (int)std::floor(y);
+	if(x0<0 || y0<0 || x0+1>=(int)gray.width || y0+1>=(int)gray.height)
+		return false;
+	float fx = x-x0;
+	float fy = y-y0;
+	const unsigned char* r0 = gray.row(y0)+x0;
+	const unsigned char* r1 = gray.row(y0+1)+x0;
+	value = (r0[0]*(1-fx) + r0[1]*fx)*(1-fy) + (r1[0]*(1-fx) + r1[1]*fx)*fy;
+	return true;
+}
+
+// Strongest edge crossing the normal of point p, searched within radius. Sub-pixel
+// position from a parabola through the gradient peak.
+bool findEdgeAlongNormal(ConstImageView gray, Point p, Point normal, float radius, float minContrast, Point& edge)
+{
+	static constexpr float STEP = 0.5f;
+	int steps = std::max(1, int(radius/STEP));
+	float profile[2*64+3];
+	steps = std::min(steps, 64);
+	for(int k=-steps-1;k<=steps+1;k++)
+		if(!sampleBilinear(gray, p.x+k*STEP*normal.x, p.y+k*STEP*normal.y, profile[k+steps+1]))
+			return false;
+
+	int best = 0;
+	float bestGradient = 0;
+	for(int k=-steps;k<=steps;k++)
+	{
+		float gradient = std::abs(profile[k+steps+2]-profile[k+steps]);
+		if(gradient>bestGradient)
+		{
+			bestGradient = gradient;
+			best = k;
+		}
+	}
+	if(bestGradient<minContrast)
+		return false;
+
+	float offset = 0;
+	if(best>-steps && best<steps)
+	{
+		float left = std::abs(profile[best+steps+1]-profile[best+steps-1]);
+		float right = std::abs(profile[best+steps+3]-profile[best+steps+1]);
+		float denominator = left-2*bestGradient+right;
+		if(denominator<0)
+			offset = 0.5f*(left-right)/denominator;
+	}
+	float s = (best+offset)*STEP;
+	edge = {p.x+s*normal.x, p.y+s*normal.y};
+	return true;
+}
+
+// Total least squares line through points (center and unit direction)
+bool fitLine(const Point* points, int count, Point& center, Point& direction)
+{
+	if(count<5)
+		return false;
+	double sx=0, sy=0;
+	for(int i=0;i<count;i++)
+	{
+		sx += points[i].x;
+		sy += points[i].y;
+	}
+	double cx = sx/count;
+	double cy = sy/count;
+	double xx=0, yy=0, xy=0;
+	for(int i=0;i<count;i++)
+	{
+		const Point& p = points[i];
+		xx += (p.x-cx)*(p.x-cx);
+		yy += (p.y-cy)*(p.y-cy);
+		xy += (p.x-cx)*(p.y-cy);
+	}
+	double angle = 0.5*atan2(2*xy, xx-yy);
+	center = {float(cx), float(cy)};
+	direction = {float(cos(angle)), float(sin(angle))};
+	return true;
+}
+
+bool fitLine(const std::vector<Point>& points, Point& center, Point& direction)
+{
+	return fitLine(points.data(), points.size(), center, direction);
+}
+
+// Refit every side of a quadrangle found at a coarse level using the full
+// resolution gray image, only inside a band of searchRadius pixels around it.
+// The corners are the intersections of the refitted sides. Returns false (quad
+// unchanged) when a side can not be refitted. The edge points are kept in the arena.
+bool refineQuadrangle(ConstImageView gray, Quadrangle& quad, float searchRadius, FrameArena& arena, float minContrast=8)
+{
+	Point corners[4] = {quad.p0, quad.p1, quad.p2, quad.p3};
+	Point centers[4];
+	Point directions[4];
+	ArenaVector<Point> edges(arena);
+	for(int i=0;i<4;i++)
+	{
+		Point a = corners[i];
+		Point b = corners[(i+1)%4];
+		float dx = b.x-a.x;
+		float dy = b.y-a.y;
+		float length = sqrt(dx*dx+dy*dy);
+		if(!(length>4))
+			return false;
+		Point direction = {dx/length, dy/length};
+		Point normal = {-direction.y, direction.x};
+
+		// Skip the ends, they are close to the other sides
+		edges.clear();
+		for(float t=0.15f*length;t<=0.85f*length;t+=1)
+		{
+			Point edge;
+			Point p = {a.x+t*direction.x, a.y+t*direction.y};
+			if(findEdgeAlongNormal(gray, p, normal, searchRadius, minContrast, edge))
+				edges.push_back(edge);
+		}
+		if(!fitLine(edges.data(), edges.size(), centers[i], directions[i]))
+			return false;
+	}
+
+	Point refined[4];
+	for(int i=0;i<4;i++)
+	{
+		// Corner i is between side i-1 and side i
+		const Point& c0 = centers[(i+3)%4];
+		const Point& d0 = directions[(i+3)%4];
+		const Point& c1 = centers[i];
+		const Point& d1 = directions[i];
+		float det = d0.x*d1.y - d0.y*d1.x;
+		if(std::abs(det)<1e-3f)
+			return false;
+		float t = ((c1.x-c0.x)*d1.y - (c1.y-c0.y)*d1.x)/det;
+		refined[i] = {c0.x+t*d0.x, c0.y+t*d0.y};
+
+		float ex = refined[i].x-corners[i].x;
+		float ey = refined[i].y-corners[i].y;
+		if(ex*ex+ey*ey > 4*searchRadius*searchRadius)
+			return false;
+	}
+	quad = {refined[0], refined[1], refined[2], refined[3]};
+	return true;
+}
+
+bool refineQuadrangle(ConstImageView gray, Quadrangle& quad, float searchRadius, float minContrast=8)
+{
+	FrameArena arena;
+	return refineQuadrangle(gray, quad, searchRadius, arena, minContrast);
+}
+
+#endif// PYRAMID_H
@@ -0,0 +1,166 @@
+//--------------------------------------------------
+// Robot Simulator
+// quadFilter.hpp
+// Date: 17/10/2026
+// By Breno Cunha Queiroz
+//--------------------------------------------------
+#ifndef QUAD_FILTER_H
+#define QUAD_FILTER_H
+#include <cmath>
+#include <algorithm>
+#include <iostream>
+#include "helpers.hpp"
+
+// Thresholds of the rejection cascade run while the 4-cycles are enumerated.
+// Stages in order: endpoint proximity and orientation alternation prune
+// partial paths, convexity, size and aspect ratio check the closed quadrangle.
+struct QuadFilter
+{
+	float maxEndpointGap = 5;// Pixels between the endpoints meeting at a corner
+	float minCornerAngle = 15;// Degrees between consecutive sides
+	float maxOppositeAngle = 60;// Degrees between opposite sides
+	float minArea = 64;// Pixels²
+	float minPerimeter = 32;// Pixels
+	float maxAspectRatio = 8;// Longest side / shortest side
+};
+
+// Candidates rejected by each stage. Path stages count pruned branches, so
+// a single rejection can remove many cycles.
+struct QuadStats
+{
+	long proximity = 0;
+	long orientation = 0;
+	long degenerate = 0;// Parallel consecutive sides
+	long convexity = 0;
+	long size = 0;
+	long aspectRatio = 0;
+	long polygon = 0;// Contours not simplified to a 4-gon (contour engine)
+	long border = 0;// Blobs touching the image border (contour engine)
+	long accepted = 0;
+
+	void merge(const QuadStats& other)
+	{
+		proximity += other.proximity;
+		orientation += other.orientation;
+		degenerate += other.degenerate;
+		convexity += other.convexity;
+		size += other.size;
+		aspectRatio += other.aspectRatio;
+		polygon += other.polygon;
+		border += other.border;
+		accepted += other.accepted;
+	}
+};
+
+// Line data used by the path stages
+struct QuadSide
+{
+	Point p[2];
+	float angle;// Direction modulo 180 degrees
+};
+
+QuadSide makeQuadSide(const Line& line)
+{
+	QuadSide side;
+	side.p[0] = line.p0;
+	side.p[1] = line.p1;
+	float angle = atan2(line.p1.y-line.p0.y, line.p1.x-line.p0.x)*180/3.14159265f;
+	side.angle = angle<0 ? angle+180 : angle;
+	return side;
+}
+
+// Angle between two undirected lines, in [0, 90]
+float sideAngle(const QuadSide& a, const QuadSide& b)
+{
+	float difference = std::abs(a.angle-b.angle);
+	return std::min(difference, 180-difference);
+}
+
+// Endpoint of side closest to other (squared distance in gap2)
+int closestEndpoint(const QuadSide& side, const QuadSide& other, float& gap2)
+{
+	gap2 = INFINITY;
+	int closest = 0;
+	for(int e=0;e<2;e++)
+		for(int k=0;k<2;k++)
+		{
+			float dx = side.p[e].x-other.p[k].x;
+			float dy = side.p[e].y-other.p[k].y;
+			if(dx*dx+dy*dy<gap2)
+			{
+				gap2 = dx*dx+dy*dy;
+				closest = e;
+			}
+		}
+	return closest;
+}
+
+// Side between previous and next: each corner must use its own endpoint and be close enough
+bool passesProximity(const QuadSide& previous, const QuadSide& side, const QuadSide& next, const QuadFilter& filter)
+{
+	float gapPrevious, gapNext;
+	int toPrevious = closestEndpoint(side, previous, gapPrevious);
+	int toNext = closestEndpoint(side, next, gapNext);
+	float maxGap2 = filter.maxEndpointGap*filter.maxEndpointGap;
+	return toPrevious!=toNext && gapPrevious<=maxGap2 && gapNext<=maxGap2;
+}
+
+// Quadrangle stages, the corners must be in order
+bool passesConvexity(const Point corners[4])
+{
+	int positive = 0;
+	int negative = 0;
+	for(int i=0;i<4;i++)
+	{
+		const Point& a = corners[i];
+		const Point& b = corners[(i+1)%4];
+		const Point& c = corners[(i+2)%4];
+		float cross = (b.x-a.x)*(c.y-b.y) - (b.y-a.y)*(c.x-b.x);
+		positive += cross>0;
+		negative += cross<0;
+	}
+	// Self intersecting quadrangles have two turns of each sign
+	return positive==4 || negative==4;
+}
+
+bool passesSize(const Point corners[4], const QuadFilter& filter)
+{
+	float area = 0;
+	float perimeter = 0;
+	for(int i=0;i<4;i++)
+	{
+		const Point& a = corners[i];
+		const Point& b = corners[(i+1)%4];
+		area += a.x*b.y - b.x*a.y;
+		perimeter += std::hypot(b.x-a.x, b.y-a.y);
+	}
+	return std::abs(area)/2>=filter.minArea && perimeter>=filter.minPerimeter;
+}
+
+bool passesAspectRatio(const Point corners[4], const QuadFilter& filter)
+{
+	float shortest = INFINITY;
+	float longest = 0;
+	for(int i=0;i<4;i++)
+	{
+		float length = std::hypot(corners[(i+1)%4].x-corners[i].x, corners[(i+1)%4].y-corners[i].y);
+		shortest = std::min(shortest, length);
+		longest = std::max(longest, length);
+	}
+	return shortest>0 && longest<=filter.maxAspectRatio*shortest;
+}
+
+void printQuadStats(const QuadStats& stats)
+{
+	std::cerr << "Quadrangles accepted: " << stats.accepted
+		<< " rejected by proximity: " << stats.proximity
+		<< " orientation: " << stats.orientation
+		<< " degenerate: " << stats.degenerate
+		<< " convexity: " << stats.convexity
+		<< " size: " << stats.size
+		<< " aspect ratio: " << stats.aspectRatio
+		<< " polygon: " << stats.polygon
+		<< " border: " << stats.border << std::endl;
+}
+
+#endif// QUAD_FILTER_H
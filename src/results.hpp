@@ -0,0 +1,177 @@
+//--------------------------------------------------
+// Robot Simulator
+// results.hpp
+// Date: 17/10/2026
+// By Breno Cunha Queiroz
+//--------------------------------------------------
+#ifndef RESULTS_H
+#define RESULTS_H
+#include <string>
+#include <cstdio>
+#include <cstdint>
+#include <iostream>
+#include <algorithm>
+#include "detector.hpp"
+
+// Binary records (little endian), one per frame: a ResultRecordHeader followed
+// by count tag records of tagSize bytes. Readers must skip tagSize bytes per tag,
+// newer versions only append fields to the tag record.
+#define RESULT_RECORD_MAGIC 0x52544741// "AGTR"
+#define RESULT_RECORD_VERSION 3
+
+struct ResultRecordHeader
+{
+	uint32_t magic;
+	uint16_t version;
+	uint16_t tagSize;
+	uint32_t frame;
+	uint32_t count;
+	double timestamp;// Seconds
+};
+
+struct ResultTagRecord
+{
+	float corners[8];// x0,y0 .. x3,y3
+	int32_t id;// Version 2, -1 when the tags are not decoded
+	float rotation[9];// Version 3, tag to camera (row major), see TagPose
+	float translation[3];
+	float poseError;// -1 when the pose is not estimated
+};
+
+enum class ResultFormat
+{
+	NONE,
+	JSON,// JSON Lines
+	BINARY
+};
+
+// Writes one record per frame to a file or stdout ("-")
+class ResultWriter
+{
+public:
+	ResultWriter() = default;
+	ResultWriter(const ResultWriter&) = delete;
+	ResultWriter& operator=(const ResultWriter&) = delete;
+	~ResultWriter() { close(); }
+
+	bool open(const std::string& path, ResultFormat format)
+	{
+		close();
+		this->format = format;
+		if(format==ResultFormat::NONE)
+			return true;
+
+		if(path=="-")
+			file = stdout;
+		else
+			file = fopen(path.c_str(), format==ResultFormat::BINARY ? "wb" : "w");
+		if(file==nullptr)
+		{
+			std::cout << "[ResultWriter] Could not open " << path << std::endl;
+			this->format = ResultFormat::NONE;
+			return false;
+		}
+		return true;
+	}
+
+	void close()
+	{
+		if(file!=nullptr && file!=stdout)
+			fclose(file);
+		else if(file==stdout)
+			fflush(file);
+		file = nullptr;
+	}
+
+	bool enabled() const { return format!=ResultFormat::NONE; }
+
+	void write(int frame, const std::string& source, double timestamp, const Detection& detection)
+	{
+		if(format==ResultFormat::JSON)
+			writeJson(frame, source, timestamp, detection);
+		else if(format==ResultFormat::BINARY)
+			writeBinary(frame, timestamp, detection);
+		// Consumers reading a pipe get every frame as soon as it is detected
+		if(file==stdout)
+			fflush(file);
+	}
+
+private:
+	// JSON string contents, written directly so that nothing is allocated
+	void writeEscaped(const std::string& text)
+	{
+		for(char c : text)
+		{
+			if(c=='"' || c=='\\')
+				fputc('\\', file);
+			if((unsigned char)c<0x20)
+				continue;
+			fputc(c, file);
+		}
+	}
+
+	void writeJson(int frame, const std::string& source, double timestamp, const Detection& detection)
+	{
+		fprintf(file, "{\"frame\":%d,\"source\":\"", frame);
+		writeEscaped(source);
+		fprintf(file, "\",\"timestamp\":%.6f,\"tags\":[", timestamp);
+		for(size_t i=0;i<detection.quadrangles.size();i++)
+		{
+			const Quadrangle& q = detection.quadrangles[i];
+			fprintf(file, "%s{", i>0 ? "," : "");
+			if(i<detection.ids.size())
+				fprintf(file, "\"id\":%d,", detection.ids[i]);
+			fprintf(file, "\"corners\":[[%.2f,%.2f],[%.2f,%.2f],[%.2f,%.2f],[%.2f,%.2f]]",
+				q.p0.x, q.p0.y, q.p1.x, q.p1.y, q.p2.x, q.p2.y, q.p3.x, q.p3.y);
+			if(i<detection.poses.size() && detection.poses[i].error>=0)
+			{
+				const TagPose& pose = detection.poses[i];
+				const float* R = pose.rotation;
+				fprintf(file, ",\"pose\":{\"rotation\":[%.6f,%.6f,%.6f,%.6f,%.6f,%.6f,%.6f,%.6f,%.6f],"
+					"\"translation\":[%.6f,%.6f,%.6f],\"error\":%.3f}",
+					R[0], R[1], R[2], R[3], R[4], R[5], R[6], R[7], R[8],
+					pose.translation[0], pose.translation[1], pose.translation[2], pose.error);
+			}
+			fprintf(file, "}");
+		}
+		fprintf(file, "]}\n");
+	}
+
+	void writeBinary(int frame, double timestamp, const Detection& detection)
+	{
+		ResultRecordHeader header;
+		header.magic = RESULT_RECORD_MAGIC;
+		header.version = RESULT_RECORD_VERSION;
+		header.tagSize = sizeof(ResultTagRecord);
+		header.frame = frame;
+		header.count = detection.quadrangles.size();
+		header.timestamp = timestamp;
+		fwrite(&header, sizeof(header), 1, file);
+		for(size_t i=0;i<detection.quadrangles.size();i++)
+		{
+			const Quadrangle& q = detection.quadrangles[i];
+			int32_t id = i<detection.ids.size() ? detection.ids[i] : -1;
+			TagPose pose = i<detection.poses.size() ? detection.poses[i] : TagPose();
+			ResultTagRecord tag{};
+			const float corners[8] = {q.p0.x, q.p0.y, q.p1.x, q.p1.y, q.p2.x, q.p2.y, q.p3.x, q.p3.y};
+			std::copy(corners, corners+8, tag.corners);
+			tag.id = id;
+			std::copy(pose.rotation, pose.rotation+9, tag.rotation);
+			std::copy(pose.translation, pose.translation+3, tag.translation);
+			tag.poseError = pose.error;
+			fwrite(&tag, sizeof(tag), 1, file);
+		}
+	}
+
+	ResultFormat format = ResultFormat::NONE;
+	FILE* file = nullptr;
+};
+
+// .bin files are binary, anything else is JSON Lines
+ResultFormat resultFormatFromPath(const std::string& path)
+{
+	std::string extension = path.size()>=4 ? path.substr(path.size()-4) : "";
+	return extension==".bin" ? ResultFormat::BINARY : ResultFormat::JSON;
+}
+
+#endif// RESULTS_H
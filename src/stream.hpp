@@ -0,0 +1,268 @@
+//--------------------------------------------------
+// Robot Simulator
+// stream.hpp
+// Date: 17/10/2026
+// By Breno Cunha Queiroz
+//--------------------------------------------------
+#ifndef STREAM_H
+#define STREAM_H
+#include <vector>
+#include <deque>
+#include <string>
+#include <sstream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <functional>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include "helpers.hpp"
+#include "batch.hpp"
+
+enum class StreamFormat
+{
+	Y4M,// Only the luma plane is used
+	GRAY8,
+	RGB24
+};
+
+// Sequential frames from stdin ("-"), a file or a named pipe
+class FrameSource
+{
+public:
+	FrameSource() = default;
+	FrameSource(const FrameSource&) = delete;
+	FrameSource& operator=(const FrameSource&) = delete;
+	~FrameSource() { close(); }
+
+	// Raw formats need the frame size, Y4M reads it from the stream header
+	bool open(const std::string& path, StreamFormat format, int width=0, int height=0)
+	{
+		close();
+		this->format = format;
+		this->width = width;
+		this->height = height;
+		file = path=="-" ? stdin : fopen(path.c_str(), "rb");
+		if(file==nullptr)
+		{
+			std::cerr << "[FrameSource] Could not open " << path << std::endl;
+			return false;
+		}
+
+		if(format==StreamFormat::Y4M)
+			return readY4mHeader();
+		if(width<=0 || height<=0)
+		{
+			std::cerr << "[FrameSource] Raw streams need the frame size" << std::endl;
+			return false;
+		}
+		channels = format==StreamFormat::RGB24 ? 3 : 1;
+		return true;
+	}
+
+	void close()
+	{
+		if(file!=nullptr && file!=stdin)
+			fclose(file);
+		file = nullptr;
+	}
+
+	int frameWidth() const { return width; }
+	int frameHeight() const { return height; }
+	int frameChannels() const { return channels; }
+
+	// Returns false at the end of the stream (or on a truncated frame).
+	// The image buffer is reused when it already has the right size.
+	bool read(Image& frame)
+	{
+		if(file==nullptr)
+			return false;
+
+		if(format==StreamFormat::Y4M && !readY4mFrameHeader())
+			return false;
+
+		if(frame.width!=(uint32_t)width || frame.height!=(uint32_t)height || frame.channels!=channels)
+			frame = createImage(width, height, channels);
+		if(fread(frame.buffer.data(), 1, frame.buffer.size(), file)!=frame.buffer.size())
+			return false;
+
+		// Chroma planes are not used
+		if(skipBytes>0)
+		{
+			skip.resize(skipBytes);
+			if(fread(skip.data(), 1, skipBytes, file)!=skipBytes)
+				return false;
+		}
+		return true;
+	}
+
+private:
+	bool readLine(std::string& line)
+	{
+		line.clear();
+		int c;
+		while((c=fgetc(file))!=EOF && c!='\n')
+			line += (char)c;
+		return c=='\n';
+	}
+
+	bool readY4mHeader()
+	{
+		std::string line;
+		if(!readLine(line) || line.compare(0, 10, "YUV4MPEG2 ")!=0)
+		{
+			std::cerr << "[FrameSource] Not a Y4M stream" << std::endl;
+			return false;
+		}
+
+		std::string colorSpace = "420";
+		std::istringstream tokens(line.substr(10));
+		std::string token;
+		while(tokens >> token)
+		{
+			if(token[0]=='W')
+				width = std::atoi(token.c_str()+1);
+			else if(token[0]=='H')
+				height = std::atoi(token.c_str()+1);
+			else if(token[0]=='C')
+				colorSpace = token.substr(1);
+		}
+
+		size_t halfW = (width+1)/2;
+		size_t halfH = (height+1)/2;
+		if(colorSpace=="mono")
+			skipBytes = 0;
+		else if(colorSpace.compare(0, 3, "420")==0)
+			skipBytes = 2*halfW*halfH;
+		else if(colorSpace=="422")
+			skipBytes = 2*halfW*height;
+		else if(colorSpace=="444")
+			skipBytes = 2*size_t(width)*height;
+		else if(colorSpace=="444alpha")
+			skipBytes = 3*size_t(width)*height;
+		else
+		{
+			std::cerr << "[FrameSource] Unsupported Y4M color space " << colorSpace << std::endl;
+			return false;
+		}
+		channels = 1;
+		return width>0 && height>0;
+	}
+
+	bool readY4mFrameHeader()
+	{
+		std::string line;
+		return readLine(line) && line.compare(0, 5, "FRAME")==0;
+	}
+
+	FILE* file = nullptr;
+	StreamFormat format = StreamFormat::GRAY8;
+	int width = 0;
+	int height = 0;
+	uint8_t channels = 1;
+	size_t skipBytes = 0;
+	std::vector<unsigned char> skip;
+};
+
+// Blocking FIFO with a fixed capacity, pop() returns false once it is closed and empty
+template<typename T>
+class BoundedQueue
+{
+public:
+	BoundedQueue(int capacity): capacity(std::max(1, capacity)) {}
+
+	void push(T item)
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		changed.wait(lock, [this]() { return (int)items.size()<capacity; });
+		items.push_back(std::move(item));
+		changed.notify_all();
+	}
+
+	bool pop(T& item)
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		changed.wait(lock, [this]() { return closed || !items.empty(); });
+		if(items.empty())
+			return false;
+		item = std::move(items.front());
+		items.pop_front();
+		changed.notify_all();
+		return true;
+	}
+
+	void close()
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		closed = true;
+		changed.notify_all();
+	}
+
+private:
+	int capacity;
+	std::deque<T> items;
+	bool closed = false;
+	std::mutex mutex;
+	std::condition_variable changed;
+};
+
+// Two stage pipeline: a reader thread decodes frame N+1 (up to depth frames
+// ahead) while process(index, frame, timestamp) runs on the calling thread for
+// frame N. Frame buffers are recycled and the latencies go to a fixed size
+// histogram, so the steady state does not allocate.
+// The timestamp is the time the frame was fully read, in seconds since the start;
+// latency is measured from that point to the end of process().
+BatchStats runStream(FrameSource& source, int depth, const std::function<void(int, ConstImageView, double)>& process)
+{
+	typedef std::chrono::steady_clock Clock;
+	struct Frame
+	{
+		Image image;
+		Clock::time_point ready;
+	};
+
+	depth = std::max(1, depth);
+	BoundedQueue<Frame> decoded(depth);
+	BoundedQueue<Image> recycled(depth+1);
+	for(int i=0;i<depth+1;i++)
+		recycled.push(Image());
+
+	Clock::time_point start = Clock::now();
+	std::thread reader([&]()
+	{
+		Frame frame;
+		while(recycled.pop(frame.image))
+		{
+			if(!source.read(frame.image))
+				break;
+			frame.ready = Clock::now();
+			decoded.push(std::move(frame));
+		}
+		decoded.close();
+	});
+
+	LatencyHistogram latencies;
+	Frame frame;
+	int index = 0;
+	while(decoded.pop(frame))
+	{
+		double timestamp = std::chrono::duration<double>(frame.ready-start).count();
+		process(index++, frame.image.view(), timestamp);
+		latencies.add(std::chrono::duration<double, std::milli>(Clock::now()-frame.ready).count());
+		recycled.push(std::move(frame.image));
+	}
+	recycled.close();
+	reader.join();
+
+	BatchStats stats;
+	stats.frames = index;
+	stats.seconds = std::chrono::duration<double>(Clock::now()-start).count();
+	stats.framesPerSecond = stats.seconds>0 ? index/stats.seconds : 0;
+	stats.p50 = latencies.percentile(0.50);
+	stats.p99 = latencies.percentile(0.99);
+	return stats;
+}
+
+#endif// STREAM_H
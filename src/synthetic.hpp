@@ -0,0 +1,208 @@
+//--------------------------------------------------
+// Robot Simulator
+// synthetic.hpp
+// Date: 17/10/2026
+// By Breno Cunha Queiroz
+//--------------------------------------------------
+#ifndef SYNTHETIC_H
+#define SYNTHETIC_H
+#include <vector>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <algorithm>
+#include "helpers.hpp"
+#include "decoder.hpp"
+
+// Random frames with known tags, used by the benchmarks
+struct SyntheticOptions
+{
+	uint32_t width = 1280;
+	uint32_t height = 960;
+	int tags = 6;
+	float minSize = 40;// Tag side (pixels)
+	float maxSize = 160;
+	int noise = 6;// Uniform noise amplitude
+	float texture = 0.3f;// Fraction of the background covered by fine texture
+	bool gradient = false;// Background from populateImage() instead of gray shading
+};
+
+struct SyntheticTag
+{
+	Quadrangle corners;// Outer corners of the black border, p0 is the top left of the code
+	int id = 0;// In defaultTagFamily()
+	uint64_t code = 0;// Inner bits, bit (row*side+col) set is white
+};
+
+struct SyntheticFrame
+{
+	Image image;// 3 channels
+	std::vector<SyntheticTag> tags;
+};
+
+// Tag intensity at (u,v) in cell units from the tag center, -1 outside the
+// quiet zone. Tag layout: the black border and code bits of the family,
+// inside a 1 cell white quiet zone.
+int syntheticTagValue(float u, float v, uint64_t code, const TagFamily& family)
+{
+	int cells = family.cells();
+	float half = cells/2.0f;
+	if(std::abs(u)>=half+1 || std::abs(v)>=half+1)
+		return -1;
+	if(std::abs(u)>=half || std::abs(v)>=half)
+		return 230;// Quiet zone
+	int col = int(u+half);
+	int row = int(v+half);
+	int border = family.border;
+	if(col<border || row<border || col>=cells-border || row>=cells-border)
+		return 20;// Border
+	return (code>>((row-border)*family.side + col-border))&1 ? 230 : 20;
+}
+
+SyntheticFrame generateSyntheticFrame(const SyntheticOptions& options, uint32_t seed)
+{
+	std::mt19937 rng(seed);
+	auto uniform = [&](float a, float b) { return std::uniform_real_distribution<float>(a, b)(rng); };
+
+	SyntheticFrame frame;
+	int width = options.width;
+	int height = options.height;
+	frame.image = createImage(width, height, 3);
+
+	// Smooth shading with patches of 2 pixel checkerboard (fine texture)
+	unsigned char* pixels = frame.image.buffer.data();
+	if(options.gradient)
+		populateImage(frame.image);
+	int patch = 64;
+	std::vector<char> textured((width/patch+1)*(height/patch+1));
+	for(auto& t : textured)
+		t = uniform(0, 1)<options.texture;
+	for(int y=0;y<height;y++)
+		for(int x=0;x<width;x++)
+		{
+			int offset = 0;
+			if(textured[(y/patch)*(width/patch+1) + x/patch])
+				offset = ((x/2+y/2)%2) ? 35 : -35;
+			for(int c=0;c<3;c++)
+			{
+				int value = options.gradient ? pixels[(y*width+x)*3+c] : 120 + 40*x/width + 30*y/height;
+				pixels[(y*width+x)*3+c] = std::min(255, std::max(0, value+offset));
+			}
+		}
+
+	// Tags do not overlap (bounding circles)
+	const TagFamily& family = defaultTagFamily();
+	int cells = family.cells();
+	struct Placed { float x, y, radius; };
+	std::vector<Placed> placed;
+	for(int t=0,attempts=0;t<options.tags && attempts<1000;attempts++)
+	{
+		float size = uniform(options.minSize, options.maxSize);
+		float cell = size/cells;
+		float radius = (cells/2.0f+1)*cell*1.42f;
+		float cx = uniform(radius, width-radius);
+		float cy = uniform(radius, height-radius);
+		if(cx>=width-radius || cy>=height-radius)
+			continue;
+		bool isFree = true;
+		for(const auto& p : placed)
+			isFree = isFree && std::hypot(cx-p.x, cy-p.y)>radius+p.radius;
+		if(!isFree)
+			continue;
+		placed.push_back({cx, cy, radius});
+
+		// Angles too close to the axes make vertical lines, which are not detected
+		float angle = uniform(0.15f, 1.5708f-0.15f) + (rng()%4)*1.5708f;
+		float c = cos(angle);
+		float s = sin(angle);
+		SyntheticTag tag;
+		tag.id = rng()%family.codes.size();
+		tag.code = family.codes[tag.id];
+
+		// Outer border corners in order
+		float half = size/2;
+		Point* corners[4] = {&tag.corners.p0, &tag.corners.p1, &tag.corners.p2, &tag.corners.p3};
+		const float signs[4][2] = {{-1,-1}, {1,-1}, {1,1}, {-1,1}};
+		for(int k=0;k<4;k++)
+			*corners[k] = {cx + c*signs[k][0]*half - s*signs[k][1]*half, cy + s*signs[k][0]*half + c*signs[k][1]*half};
+
+		// 4x4 supersampling, (u,v) in cells
+		int x0 = std::max(0, int(cx-radius));
+		int x1 = std::min(width-1, int(cx+radius));
+		int y0 = std::max(0, int(cy-radius));
+		int y1 = std::min(height-1, int(cy+radius));
+		for(int y=y0;y<=y1;y++)
+			for(int x=x0;x<=x1;x++)
+			{
+				int sum = 0;
+				int inside = 0;
+				for(int sy=0;sy<4;sy++)
+					for(int sx=0;sx<4;sx++)
+					{
+						float dx = x-0.375f+sx*0.25f-cx;
+						float dy = y-0.375f+sy*0.25f-cy;
+						int value = syntheticTagValue((c*dx+s*dy)/cell, (-s*dx+c*dy)/cell, tag.code, family);
+						if(value>=0)
+						{
+							sum += value;
+							inside++;
+						}
+					}
+				if(inside>0)
+					for(int c=0;c<3;c++)
+						pixels[(y*width+x)*3+c] = (sum + (16-inside)*pixels[(y*width+x)*3+c])/16;
+			}
+		frame.tags.push_back(tag);
+		t++;
+	}
+
+	for(int i=0;i<width*height;i++)
+	{
+		int noise = int(uniform(-options.noise, options.noise+1));
+		for(int c=0;c<3;c++)
+			pixels[i*3+c] = std::min(255, std::max(0, pixels[i*3+c]+noise));
+	}
+	return frame;
+}
+
+// Largest corner distance between two quadrangles over the cyclic orders and
+// both orientations of b
+float quadrangleDistance(const Quadrangle& a, const Quadrangle& b)
+{
+	const Point pa[4] = {a.p0, a.p1, a.p2, a.p3};
+	const Point pb[4] = {b.p0, b.p1, b.p2, b.p3};
+	float best = INFINITY;
+	for(int direction=-1;direction<=1;direction+=2)
+		for(int shift=0;shift<4;shift++)
+		{
+			float worst = 0;
+			for(int k=0;k<4;k++)
+			{
+				const Point& q = pb[((shift+direction*k)%4+4)%4];
+				worst = std::max(worst, (float)std::hypot(pa[k].x-q.x, pa[k].y-q.y));
+			}
+			best = std::min(best, worst);
+		}
+	return best;
+}
+
+// Number of tags matched by some detected quadrangle within tolerance pixels
+int countFoundTags(const std::vector<SyntheticTag>& tags, const std::vector<Quadrangle>& detected, float tolerance, float* errorSum=nullptr)
+{
+	int found = 0;
+	for(const auto& tag : tags)
+	{
+		float best = INFINITY;
+		for(const auto& quad : detected)
+			best = std::min(best, quadrangleDistance(tag.corners, quad));
+		if(best<=tolerance)
+		{
+			found++;
+			if(errorSum!=nullptr)
+				*errorSum += best;
+		}
+	}
+	return found;
+}
+
+#endif// SYNTHETIC_H
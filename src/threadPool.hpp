@@ -0,0 +1,151 @@
+//--------------------------------------------------
+// Robot Simulator
+// threadPool.hpp
+// Date: 17/10/2026
+// By Breno Cunha Queiroz
+//--------------------------------------------------
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstdint>
+#include <algorithm>
+
+// Persistent worker threads. The thread calling parallelFor() also runs
+// pending jobs while it waits, so nested parallelFor() calls can not deadlock.
+// Queued tasks only point to the caller's job, so nothing is allocated once
+// the queue has grown to its largest size.
+class ThreadPool
+{
+public:
+	ThreadPool(int numThreads)
+	{
+		for(int i=0;i<numThreads;i++)
+			workers.emplace_back([this]()
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				while(true)
+				{
+					wake.wait(lock, [this]() { return stop || !empty(); });
+					if(stop && empty())
+						return;
+					runPending(lock);
+				}
+			});
+	}
+
+	~ThreadPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stop = true;
+		}
+		wake.notify_all();
+		for(auto& worker : workers)
+			worker.join();
+	}
+
+	int size() const { return workers.size(); }
+
+	// Run job(i) for every i in [0,count) and wait for all of them
+	template<typename Job>
+	void parallelFor(int count, const Job& job)
+	{
+		if(count<=0)
+			return;
+
+		int remaining = count;
+		std::unique_lock<std::mutex> lock(mutex);
+		for(int i=1;i<count;i++)
+			tasks.push_back({&runJob<Job>, &job, i, &remaining});
+		wake.notify_all();
+
+		// The caller takes the first job
+		lock.unlock();
+		job(0);
+		lock.lock();
+		remaining--;
+
+		while(remaining>0)
+			if(!runPending(lock))
+				finished.wait(lock);
+	}
+
+private:
+	struct Task
+	{
+		void (*run)(const void* job, int index);
+		const void* job;
+		int index;
+		int* remaining;// Jobs of the parallelFor() call not finished yet
+	};
+
+	template<typename Job>
+	static void runJob(const void* job, int index)
+	{
+		(*static_cast<const Job*>(job))(index);
+	}
+
+	bool empty() const { return head==tasks.size(); }
+
+	// Run one queued task without holding the lock, returns false if there was none
+	bool runPending(std::unique_lock<std::mutex>& lock)
+	{
+		if(empty())
+			return false;
+		Task task = tasks[head++];
+		if(empty())
+		{
+			tasks.clear();
+			head = 0;
+		}
+		lock.unlock();
+		task.run(task.job, task.index);
+		lock.lock();
+		if(--*task.remaining==0)
+			finished.notify_all();
+		return true;
+	}
+
+	std::vector<std::thread> workers;
+	std::vector<Task> tasks;// FIFO, tasks[head..] are pending
+	size_t head = 0;
+	std::mutex mutex;
+	std::condition_variable wake;
+	std::condition_variable finished;
+	bool stop = false;
+};
+
+int hardwareThreads()
+{
+	return std::max(1u, std::thread::hardware_concurrency());
+}
+
+// Shared pool, the calling thread is the extra one
+ThreadPool& threadPool()
+{
+	static ThreadPool pool(hardwareThreads()-1);
+	return pool;
+}
+
+// Split the rows [0,height) in numThreads contiguous bands and run band(y0, y1) for each.
+// Bands only depend on the row count, so results do not depend on scheduling.
+template<typename Band>
+void parallelRows(int height, int numThreads, const Band& band)
+{
+	int bands = std::max(1, std::min(numThreads, height));
+	if(bands==1)
+	{
+		band(0, height);
+		return;
+	}
+
+	threadPool().parallelFor(bands, [&](int i)
+	{
+		band(int(int64_t(height)*i/bands), int(int64_t(height)*(i+1)/bands));
+	});
+}
+
+#endif// THREAD_POOL_H
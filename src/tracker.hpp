@@ -0,0 +1,214 @@
+//--------------------------------------------------
+// Robot Simulator
+// tracker.hpp
+// Date: 17/10/2026
+// By Breno Cunha Queiroz
+//--------------------------------------------------
+#ifndef TRACKER_H
+#define TRACKER_H
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include "helpers.hpp"
+#include "detector.hpp"
+
+struct Rect
+{
+	int x = 0;
+	int y = 0;
+	int width = 0;
+	int height = 0;
+
+	int area() const { return width*height; }
+	bool overlaps(const Rect& other) const
+	{
+		return x<other.x+other.width && other.x<x+width && y<other.y+other.height && other.y<y+height;
+	}
+	Rect merge(const Rect& other) const
+	{
+		Rect result;
+		result.x = std::min(x, other.x);
+		result.y = std::min(y, other.y);
+		result.width = std::max(x+width, other.x+other.width)-result.x;
+		result.height = std::max(y+height, other.y+other.height)-result.y;
+		return result;
+	}
+};
+
+// Run the whole pipeline inside rect, the quadrangles are returned in image coordinates
+void detectARtags(ConstImageView image, Rect rect, int levels, Detection& detection, DetectorWorkspace& workspace, int numThreads=1,
+		QuadEngine engine=QuadEngine::LINES)
+{
+	detectARtagsPyramid(image.sub(rect.x, rect.y, rect.width, rect.height), levels, detection, workspace, numThreads, engine);
+	for(auto& quad : detection.quadrangles)
+		for(Point* p : {&quad.p0, &quad.p1, &quad.p2, &quad.p3})
+		{
+			p->x += rect.x;
+			p->y += rect.y;
+		}
+}
+
+Detection detectARtags(ConstImageView image, Rect rect, int levels=0, int numThreads=1, QuadEngine engine=QuadEngine::LINES)
+{
+	DetectorWorkspace workspace;
+	Detection detection;
+	detectARtags(image, rect, levels, detection, workspace, numThreads, engine);
+	return detection;
+}
+
+// Re-detects only around the quadrangles of the previous frame. A full frame
+// scan runs every fullScanEvery frames, when nothing is tracked, when the
+// regions would cover most of the frame or when a region loses any of its
+// tags (finds fewer quadrangles than it held in the previous frame).
+// Both the scans and the regions run on levels pyramid levels, the regions
+// are aligned on the coarsest level so their pixels are the ones of the frame.
+// Like a Detector, the tracker owns its scratch memory and its detection.
+class TagTracker
+{
+public:
+	TagTracker(int fullScanEvery=30, int levels=0, QuadEngine engine=QuadEngine::LINES, float margin=0.5f, int minMargin=16):
+		fullScanEvery(std::max(1, fullScanEvery)), levels(std::max(0, levels)), engine(engine), margin(margin), minMargin(minMargin) {}
+	TagTracker(const TagTracker&) = delete;
+	TagTracker& operator=(const TagTracker&) = delete;
+
+	// The detection is valid until the next call. With keepEdgels the edgels of
+	// the regions are pasted in a frame sized edgel image, so the detection can
+	// be rendered like a full scan.
+	Detection& update(ConstImageView image, int numThreads=1, bool keepEdgels=false)
+	{
+		workspace.arena.reset();
+		trackedRegions(image);
+		if(framesSinceScan+1>=fullScanEvery || regions.empty())
+			return fullScan(image, numThreads);
+
+		resetDetection(detection, workspace);
+		detection.border = engine==QuadEngine::LINES ? detectionKernel().radius : 0;
+		detection.scale = 1<<levels;
+		if(keepEdgels)
+		{
+			detection.edgels = workspace.images.acquire(std::max(0, int(image.width>>levels)-2*detection.border),
+				std::max(0, int(image.height>>levels)-2*detection.border), 1);
+			std::fill(detection.edgels.buffer.begin(), detection.edgels.buffer.end(), 0);
+		}
+		for(size_t i=0;i<regions.size();i++)
+		{
+			// The quadrangles of the previous regions are already copied out of the arena
+			const Rect& rect = regions[i];
+			workspace.arena.reset();
+			detectARtags(image, rect, levels, region, workspace, numThreads, engine);
+			if((int)region.quadrangles.size()<regionQuads[i])
+				return fullScan(image, numThreads);// Track lost
+
+			detection.quadrangles.insert(detection.quadrangles.end(), region.quadrangles.begin(), region.quadrangles.end());
+			detection.quadStats.merge(region.quadStats);
+			if(keepEdgels && region.scale==detection.scale)
+				pasteEdgels(region.edgels.view(), rect.x/detection.scale, rect.y/detection.scale, detection.edgels.view());
+		}
+		previous.assign(detection.quadrangles.begin(), detection.quadrangles.end());
+		framesSinceScan++;
+		lastFullScan = false;
+		return detection;
+	}
+
+	bool wasFullScan() const { return lastFullScan; }
+
+	// Holds the scratch memory of the later stages of the frame (e.g. decodeTags)
+	FrameArena& arena() { return workspace.arena; }
+
+private:
+	Detection& fullScan(ConstImageView image, int numThreads)
+	{
+		workspace.arena.reset();
+		detectARtagsPyramid(image, levels, detection, workspace, numThreads, engine);
+		previous.assign(detection.quadrangles.begin(), detection.quadrangles.end());
+		framesSinceScan = 0;
+		lastFullScan = true;
+		return detection;
+	}
+
+	// Region edgel (x,y) is the frame edgel (x+x0,y+y0), clipped to the frame
+	static void pasteEdgels(ConstImageView region, int x0, int y0, ImageView edgels)
+	{
+		int width = std::min((int)region.width, (int)edgels.width-x0);
+		int height = std::min((int)region.height, (int)edgels.height-y0);
+		for(int y=0;y<height;y++)
+			std::copy(region.row(y), region.row(y)+std::max(0, width), edgels.row(y+y0)+x0);
+	}
+
+	// Expanded bounding boxes of the previous quadrangles in regions, overlapping
+	// boxes are merged. regionQuads counts the previous quadrangles of each region.
+	void trackedRegions(ConstImageView image)
+	{
+		regions.clear();
+		regionQuads.clear();
+		for(const auto& quad : previous)
+		{
+			float minX = INFINITY, minY = INFINITY, maxX = -INFINITY, maxY = -INFINITY;
+			for(const Point& p : {quad.p0, quad.p1, quad.p2, quad.p3})
+			{
+				minX = std::min(minX, p.x);
+				minY = std::min(minY, p.y);
+				maxX = std::max(maxX, p.x);
+				maxY = std::max(maxY, p.y);
+			}
+			if(!std::isfinite(minX) || !std::isfinite(minY) || !std::isfinite(maxX) || !std::isfinite(maxY))
+				continue;
+
+			float expand = std::max(float(minMargin), margin*std::max(maxX-minX, maxY-minY));
+			int align = 1<<levels;
+			Rect rect;
+			rect.x = std::max(0, int(std::floor(minX-expand)))/align*align;
+			rect.y = std::max(0, int(std::floor(minY-expand)))/align*align;
+			rect.width = std::min((int)image.width, int(std::ceil(maxX+expand)))-rect.x;
+			rect.height = std::min((int)image.height, int(std::ceil(maxY+expand)))-rect.y;
+			if(rect.width>0 && rect.height>0)
+			{
+				regions.push_back(rect);
+				regionQuads.push_back(1);
+			}
+		}
+
+		// Merge until no two regions overlap, so no tag is reported twice
+		bool merged = true;
+		while(merged)
+		{
+			merged = false;
+			for(size_t i=0;i<regions.size() && !merged;i++)
+				for(size_t j=i+1;j<regions.size() && !merged;j++)
+					if(regions[i].overlaps(regions[j]))
+					{
+						regions[i] = regions[i].merge(regions[j]);
+						regionQuads[i] += regionQuads[j];
+						regions.erase(regions.begin()+j);
+						regionQuads.erase(regionQuads.begin()+j);
+						merged = true;
+					}
+		}
+
+		// Not worth it when the regions cover most of the frame
+		int area = 0;
+		for(const auto& rect : regions)
+			area += rect.area();
+		if(area*2>int(image.width*image.height))
+		{
+			regions.clear();
+			regionQuads.clear();
+		}
+	}
+
+	int fullScanEvery;
+	int levels;
+	QuadEngine engine;
+	float margin;// Fraction of the tag size added around it
+	int minMargin;// Pixels
+	DetectorWorkspace workspace;
+	Detection detection;
+	Detection region;
+	std::vector<Rect> regions;
+	std::vector<int> regionQuads;
+	std::vector<Quadrangle> previous;
+	int framesSinceScan = 0;
+	bool lastFullScan = true;
+};
+
+#endif// TRACKER_H